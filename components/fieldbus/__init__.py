@@ -0,0 +1,111 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import sensor
+from esphome.core import CORE
+from esphome.const import ENTITY_CATEGORY_DIAGNOSTIC, STATE_CLASS_MEASUREMENT, STATE_CLASS_TOTAL_INCREASING
+
+# Bus instrumentation shared by save_vtr and m5stack420ma; loaded by them, not configured
+CODEOWNERS = ["@atleso"]
+AUTO_LOAD = ["sensor"]
+
+fieldbus_ns = cg.esphome_ns.namespace("fieldbus")
+FieldbusStats = fieldbus_ns.class_("FieldbusStats")
+HistoryBackfill = fieldbus_ns.class_("HistoryBackfill", cg.Component)
+
+CONF_TRANSACTION_LATENCY = "transaction_latency"
+CONF_BUS_ERRORS = "bus_errors"
+CONF_BUS_RETRIES = "bus_retries"
+CONF_POLL_CYCLE_TIME = "poll_cycle_time"
+CONF_TRACE = "trace"
+CONF_BUFFER_SIZE = "buffer_size"
+CONF_LAZY_FLUSH = "lazy_flush"
+CONF_HISTORY = "history"
+CONF_BACKFILL_ID = "backfill_id"
+
+
+def _diagnostic(unit, icon, decimals, state_class):
+    return sensor.sensor_schema(
+        unit_of_measurement=unit,
+        icon=icon,
+        accuracy_decimals=decimals,
+        state_class=state_class,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+    )
+
+
+# Diagnostic sensors: slowest transaction and poll cycle per update, error and retry totals
+STATS_SENSOR_SCHEMA = {
+    cv.Optional(CONF_TRANSACTION_LATENCY): _diagnostic("ms", "mdi:timer-outline", 1, STATE_CLASS_MEASUREMENT),
+    cv.Optional(CONF_POLL_CYCLE_TIME): _diagnostic("ms", "mdi:timer-sync-outline", 1, STATE_CLASS_MEASUREMENT),
+    cv.Optional(CONF_BUS_ERRORS): _diagnostic("", "mdi:alert-circle-outline", 0, STATE_CLASS_TOTAL_INCREASING),
+    cv.Optional(CONF_BUS_RETRIES): _diagnostic("", "mdi:refresh", 0, STATE_CLASS_TOTAL_INCREASING),
+}
+
+STATS_SENSORS = {
+    CONF_TRANSACTION_LATENCY: "set_latency_sensor",
+    CONF_POLL_CYCLE_TIME: "set_cycle_time_sensor",
+    CONF_BUS_ERRORS: "set_error_sensor",
+    CONF_BUS_RETRIES: "set_retry_sensor",
+}
+
+
+async def register_stats_sensors(stats, config):
+    # `stats` is the component's FieldbusStats reference, e.g. var.get_fieldbus_stats()
+    for key, setter in STATS_SENSORS.items():
+        if key in config:
+            sens = await sensor.new_sensor(config[key])
+            cg.add(getattr(stats, setter)(sens))
+
+
+# Record bus events in a RAM ring instead of logging each one as it happens; they are
+# logged a few at a time while the bus is idle (lazy_flush) or by the dump_trace action
+TRACE_SCHEMA = {
+    cv.Optional(CONF_TRACE): cv.Schema(
+        {
+            cv.Optional(CONF_BUFFER_SIZE, default=128): cv.int_range(min=8, max=2048),
+            cv.Optional(CONF_LAZY_FLUSH, default=True): cv.boolean,
+        }
+    ),
+}
+
+
+async def register_trace(trace, config):
+    # `trace` is the component's TraceBuffer reference, e.g. var.get_trace()
+    if CONF_TRACE in config:
+        cg.add(trace.set_capacity(config[CONF_TRACE][CONF_BUFFER_SIZE]))
+        cg.add(trace.set_lazy_flush(config[CONF_TRACE][CONF_LAZY_FLUSH]))
+
+
+# Buffer every published value of the component's sensors while no API client is connected
+# and send it as esphome.fieldbus_history events once one is back; buffer_size is per sensor
+HISTORY_SCHEMA = {
+    cv.Optional(CONF_HISTORY): cv.Schema(
+        {
+            # Every history block declares one; the first creates the backfill component under
+            # its ID and all others share it
+            cv.GenerateID(CONF_BACKFILL_ID): cv.declare_id(HistoryBackfill),
+            cv.Optional(CONF_BUFFER_SIZE, default=256): cv.int_range(min=32, max=8192),
+        }
+    ),
+}
+
+
+async def _history_backfill(config):
+    # One backfill component serves the sensors of every field-bus component
+    data = CORE.data.setdefault("fieldbus", {})
+    if "history" not in data:
+        var = cg.new_Pvariable(config[CONF_HISTORY][CONF_BACKFILL_ID])
+        await cg.register_component(var, {})
+        # The batches go out as Home Assistant events, which the API only compiles in with this
+        if "api" in CORE.config:
+            cg.add_define("USE_API_HOMEASSISTANT_SERVICES")
+        data["history"] = var
+    return data["history"]
+
+
+async def register_history(sensors, config):
+    if CONF_HISTORY not in config or not sensors:
+        return
+    backfill = await _history_backfill(config)
+    for sens in sensors:
+        cg.add(backfill.add_sensor(sens, config[CONF_HISTORY][CONF_BUFFER_SIZE]))
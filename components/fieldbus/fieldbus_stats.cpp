@@ -0,0 +1,101 @@
+#include "fieldbus_stats.h"
+#include "esphome/core/log.h"
+#include <algorithm>
+#include <cinttypes>
+
+namespace esphome {
+namespace fieldbus {
+
+static const char *const TAG = "fieldbus";
+
+void LatencyHistogram::record(uint32_t latency) {
+  const uint32_t scaled = latency / FIRST_BOUND;
+  const uint8_t bucket = scaled == 0 ? 0 : std::min<uint8_t>(32 - __builtin_clz(scaled), BUCKET_COUNT - 1);
+  this->buckets_[bucket]++;
+  this->count_++;
+  this->max_ = std::max(this->max_, latency);
+  this->total_ += latency;
+}
+
+uint32_t LatencyHistogram::percentile(uint8_t percent) const {
+  if (this->count_ == 0)
+    return 0;
+  const uint32_t rank = (uint64_t(this->count_) * percent + 99) / 100;
+  uint32_t seen = 0;
+  for (uint8_t i = 0; i + 1 < BUCKET_COUNT; i++) {
+    seen += this->buckets_[i];
+    if (seen >= rank)
+      return bucket_bound(i);
+  }
+  return this->max_;
+}
+
+void LatencyHistogram::dump(const char *tag, const char *label) const {
+  if (this->count_ == 0) {
+    ESP_LOGCONFIG(tag, "    %s: no transactions", label);
+    return;
+  }
+  ESP_LOGCONFIG(tag, "    %s: %" PRIu32 " transactions, mean %" PRIu32 "us, p50 <%" PRIu32 "us, p95 <%" PRIu32
+                "us, max %" PRIu32 "us",
+                label, this->count_, this->mean(), this->percentile(50), this->percentile(95), this->max_);
+}
+
+void FieldbusStats::record_transaction(uint8_t kind, uint32_t latency) {
+  this->overall_.record(latency);
+  if (kind < this->kinds_.size())
+    this->kinds_[kind].record(latency);
+  this->window_latency_max_ = std::max(this->window_latency_max_, latency);
+}
+
+void FieldbusStats::record_error(ErrorKind kind) {
+  if (kind < ERROR_KIND_COUNT)
+    this->errors_[kind]++;
+}
+
+void FieldbusStats::record_cycle(uint32_t duration) {
+  this->cycles_++;
+  this->cycle_total_ += duration;
+  this->cycle_max_ = std::max(this->cycle_max_, duration);
+  this->window_cycle_max_ = std::max(this->window_cycle_max_, duration);
+}
+
+uint32_t FieldbusStats::errors() const {
+  uint32_t total = 0;
+  for (uint32_t count : this->errors_)
+    total += count;
+  return total;
+}
+
+void FieldbusStats::publish() {
+  if (this->latency_sensor_ != nullptr)
+    this->latency_sensor_->publish_state(this->window_latency_max_ / 1000.0f);
+  if (this->cycle_time_sensor_ != nullptr)
+    this->cycle_time_sensor_->publish_state(this->window_cycle_max_ / 1000.0f);
+  if (this->error_sensor_ != nullptr)
+    this->error_sensor_->publish_state(this->errors());
+  if (this->retry_sensor_ != nullptr)
+    this->retry_sensor_->publish_state(this->retries_);
+  this->window_latency_max_ = 0;
+  this->window_cycle_max_ = 0;
+}
+
+void FieldbusStats::dump_config(const char *tag) const {
+  ESP_LOGCONFIG(tag, "  Bus transactions:");
+  this->overall_.dump(tag, "All");
+  ESP_LOGCONFIG(tag,
+                "    Errors: %" PRIu32 " timeouts, %" PRIu32 " short responses, %" PRIu32 " NACKs; %" PRIu32
+                " retries",
+                this->errors_[ERROR_TIMEOUT], this->errors_[ERROR_SHORT_RESPONSE], this->errors_[ERROR_NACK],
+                this->retries_);
+  if (this->cycles_ > 0) {
+    ESP_LOGCONFIG(tag, "    Poll cycles: %" PRIu32 ", mean %" PRIu32 "us, max %" PRIu32 "us", this->cycles_,
+                  static_cast<uint32_t>(this->cycle_total_ / this->cycles_), this->cycle_max_);
+  }
+  LOG_SENSOR("    ", "Latency", this->latency_sensor_);
+  LOG_SENSOR("    ", "Errors", this->error_sensor_);
+  LOG_SENSOR("    ", "Retries", this->retry_sensor_);
+  LOG_SENSOR("    ", "Poll Cycle Time", this->cycle_time_sensor_);
+}
+
+}  // namespace fieldbus
+}  // namespace esphome
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "esphome/components/sensor/sensor.h"
+
+namespace esphome {
+namespace fieldbus {
+
+enum ErrorKind : uint8_t {
+  ERROR_TIMEOUT = 0,     // no answer at all
+  ERROR_SHORT_RESPONSE,  // answer shorter than requested
+  ERROR_NACK,            // device did not acknowledge (I2C) or rejected the request
+  ERROR_KIND_COUNT,
+};
+
+// Transaction latencies in fixed power-of-two buckets: below 250us, below 500us, ... up to
+// 256ms, and one bucket for anything slower. Recording is a shift and an increment.
+class LatencyHistogram {
+ public:
+  static constexpr uint8_t BUCKET_COUNT = 12;
+  static constexpr uint32_t FIRST_BOUND = 250;  // us
+
+  void record(uint32_t latency);
+  uint32_t count() const { return this->count_; }
+  uint32_t max() const { return this->max_; }
+  uint32_t mean() const { return this->count_ == 0 ? 0 : this->total_ / this->count_; }
+  // Upper bound of the bucket holding the given percentile, in us
+  uint32_t percentile(uint8_t percent) const;
+  void dump(const char *tag, const char *label) const;
+
+  static uint32_t bucket_bound(uint8_t bucket) { return FIRST_BOUND << bucket; }
+
+ protected:
+  uint32_t buckets_[BUCKET_COUNT]{};
+  uint32_t count_{0};
+  uint32_t max_{0};
+  uint64_t total_{0};
+};
+
+// Instrumentation shared by the field-bus components: latency per transaction kind (a
+// register block, a register kind, ...) and overall, error and retry counters and poll
+// cycle durations. Optional diagnostic sensors get the figures on every publish().
+class FieldbusStats {
+ public:
+  // Transaction that only counts towards the overall histogram
+  static constexpr uint8_t NO_KIND = UINT8_MAX;
+
+  // Number of transaction kinds with their own histogram
+  void set_kind_count(uint8_t count) { this->kinds_.resize(count); }
+  void set_latency_sensor(sensor::Sensor *sensor) { this->latency_sensor_ = sensor; }
+  void set_error_sensor(sensor::Sensor *sensor) { this->error_sensor_ = sensor; }
+  void set_retry_sensor(sensor::Sensor *sensor) { this->retry_sensor_ = sensor; }
+  void set_cycle_time_sensor(sensor::Sensor *sensor) { this->cycle_time_sensor_ = sensor; }
+
+  // A transaction answered after `latency` us
+  void record_transaction(uint8_t kind, uint32_t latency);
+  void record_error(ErrorKind kind);
+  void record_retry() { this->retries_++; }
+  // One poll cycle (all reads of an update) took `duration` us
+  void record_cycle(uint32_t duration);
+
+  uint32_t errors() const;
+  uint32_t errors(ErrorKind kind) const { return this->errors_[kind]; }
+  uint32_t retries() const { return this->retries_; }
+  uint32_t cycles() const { return this->cycles_; }
+  const LatencyHistogram &overall() const { return this->overall_; }
+  const LatencyHistogram &kind(uint8_t kind) const { return this->kinds_[kind]; }
+  uint8_t kind_count() const { return this->kinds_.size(); }
+
+  // Slowest transaction and cycle since the last publish (ms), error and retry totals
+  void publish();
+  void dump_config(const char *tag) const;
+
+ protected:
+  LatencyHistogram overall_;
+  std::vector<LatencyHistogram> kinds_;
+  uint32_t errors_[ERROR_KIND_COUNT]{};
+  uint32_t retries_{0};
+  uint32_t cycles_{0};
+  uint32_t cycle_max_{0};
+  uint64_t cycle_total_{0};
+  uint32_t window_latency_max_{0};
+  uint32_t window_cycle_max_{0};
+
+  sensor::Sensor *latency_sensor_{nullptr};
+  sensor::Sensor *error_sensor_{nullptr};
+  sensor::Sensor *retry_sensor_{nullptr};
+  sensor::Sensor *cycle_time_sensor_{nullptr};
+};
+
+}  // namespace fieldbus
+}  // namespace esphome
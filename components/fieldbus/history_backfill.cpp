@@ -0,0 +1,84 @@
+#include "history_backfill.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+#include <cinttypes>
+
+#ifdef USE_API
+#include "esphome/components/api/api_server.h"
+#endif
+
+namespace esphome {
+namespace fieldbus {
+
+static const char *const TAG = "fieldbus.history";
+
+void HistoryBackfill::setup() {
+  size_t total = 0;
+  for (const auto &entry : this->entries_)
+    total += entry.buffer_size;
+  this->storage_.reset(new uint8_t[total]);
+  uint8_t *storage = this->storage_.get();
+  for (auto &entry : this->entries_) {
+    entry.buffer.init(storage, entry.buffer_size, entry.sensor->get_accuracy_decimals());
+    storage += entry.buffer_size;
+    // entries_ does not change after setup(), so the pointer stays valid
+    Entry *target = &entry;
+    entry.sensor->add_on_state_callback([this, target](float value) {
+      if (!this->connected_)
+        target->buffer.record(millis(), value);
+    });
+  }
+}
+
+bool HistoryBackfill::is_connected_() const {
+#ifdef USE_API
+  return api::global_api_server != nullptr && api::global_api_server->is_connected();
+#else
+  return true;
+#endif
+}
+
+// One event per loop() iteration, so a long outage does not stall the loop on reconnect
+void HistoryBackfill::loop() {
+  const bool connected = this->is_connected_();
+  const uint32_t now = millis();
+  if (connected != this->connected_) {
+    this->connected_ = connected;
+    this->backfill_pending_ = connected;
+    this->connected_since_ = now;
+    this->next_entry_ = 0;
+    return;
+  }
+  if (!this->backfill_pending_ || now - this->connected_since_ < SETTLE_TIME)
+    return;
+  while (this->next_entry_ < this->entries_.size() && this->entries_[this->next_entry_].buffer.empty())
+    this->next_entry_++;
+  if (this->next_entry_ == this->entries_.size()) {
+    this->backfill_pending_ = false;
+    return;
+  }
+  auto &entry = this->entries_[this->next_entry_];
+  const uint16_t count = entry.buffer.drain(now, this->batch_, BATCH_SIZE);
+#if defined(USE_API) && defined(USE_API_HOMEASSISTANT_SERVICES)
+  this->fire_homeassistant_event("esphome.fieldbus_history", {
+      {"sensor", entry.sensor->get_object_id()},
+      {"decimals", std::to_string(entry.buffer.decimals())},
+      {"samples", this->batch_},
+  });
+#endif
+  ESP_LOGD(TAG, "Sent %u buffered samples of '%s'", count, entry.sensor->get_name().c_str());
+}
+
+void HistoryBackfill::dump_config() {
+  ESP_LOGCONFIG(TAG, "Fieldbus history backfill:");
+#ifndef USE_API
+  ESP_LOGCONFIG(TAG, "  No API configured; nothing is buffered");
+#endif
+  for (const auto &entry : this->entries_) {
+    ESP_LOGCONFIG(TAG, "  '%s': %u bytes, %u in use, %" PRIu32 " samples dropped", entry.sensor->get_name().c_str(),
+                  entry.buffer.size(), entry.buffer.used(), entry.buffer.dropped());
+  }
+}
+
+}  // namespace fieldbus
+}  // namespace esphome
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "esphome/core/component.h"
+#include "esphome/core/defines.h"
+#include "esphome/components/sensor/sensor.h"
+#include "history_buffer.h"
+
+#ifdef USE_API
+#include "esphome/components/api/custom_api_device.h"
+#endif
+
+namespace esphome {
+namespace fieldbus {
+
+// Keeps what the field-bus sensors publish while no API client is connected and, once one
+// is back, sends it to Home Assistant as `esphome.fieldbus_history` events: one compact
+// batch per sensor instead of a replay of every state. All buffers share one allocation
+// made in setup(); recording never allocates.
+class HistoryBackfill : public Component
+#ifdef USE_API
+    , public api::CustomAPIDevice
+#endif
+{
+ public:
+  static constexpr uint32_t SETTLE_TIME = 10000;  // ms after reconnecting, so HA is subscribed
+  static constexpr size_t BATCH_SIZE = 512;       // characters of samples per event
+
+  // Buffer `buffer_size` bytes of this sensor's history; call before setup()
+  void add_sensor(sensor::Sensor *sensor, uint16_t buffer_size) {
+    this->entries_.push_back({sensor, buffer_size, {}});
+  }
+
+  void setup() override;
+  void loop() override;
+  void dump_config() override;
+  float get_setup_priority() const override { return setup_priority::DATA; }
+
+ protected:
+  struct Entry {
+    sensor::Sensor *sensor;
+    uint16_t buffer_size;
+    HistoryBuffer buffer;
+  };
+
+  bool is_connected_() const;
+
+  std::vector<Entry> entries_;
+  std::unique_ptr<uint8_t[]> storage_;
+  bool connected_{false};
+  uint32_t connected_since_{0};
+  bool backfill_pending_{false};
+  size_t next_entry_{0};
+  char batch_[BATCH_SIZE];
+};
+
+}  // namespace fieldbus
+}  // namespace esphome
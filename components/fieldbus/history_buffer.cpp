@@ -0,0 +1,126 @@
+#include "history_buffer.h"
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace esphome {
+namespace fieldbus {
+
+static uint8_t write_varint(uint32_t value, uint8_t *out) {
+  uint8_t length = 0;
+  while (value >= 0x80) {
+    out[length++] = static_cast<uint8_t>(value) | 0x80;
+    value >>= 7;
+  }
+  out[length++] = static_cast<uint8_t>(value);
+  return length;
+}
+
+void HistoryBuffer::init(uint8_t *storage, uint16_t size, int8_t decimals) {
+  this->data_ = storage;
+  this->size_ = size;
+  this->decimals_ = decimals < 0 ? 0 : (decimals > 4 ? 4 : decimals);
+  this->scale_ = std::pow(10.0f, this->decimals_);
+}
+
+void HistoryBuffer::record(uint32_t now, float value) {
+  if (this->size_ == 0)
+    return;
+  if (this->used_ == 0) {
+    this->base_time_ = this->last_time_ = now;
+    this->base_value_ = this->last_value_;
+  }
+  // Whole ticks only, so rounding does not accumulate over many samples
+  const uint32_t dt = (now - this->last_time_) / TICK;
+  this->last_time_ += dt * TICK;
+  const bool nan = std::isnan(value);
+  uint8_t encoded[10];
+  uint8_t length = write_varint((dt << 1) | (nan ? 1 : 0), encoded);
+  if (!nan) {
+    const float scaled = std::round(value * this->scale_);
+    const int32_t q = scaled >= 2147483520.0f ? INT32_MAX : (scaled <= -2147483520.0f ? INT32_MIN : int32_t(scaled));
+    const int32_t dq = int32_t(uint32_t(q) - uint32_t(this->last_value_));
+    length += write_varint((uint32_t(dq) << 1) ^ uint32_t(dq >> 31), encoded + length);
+    this->last_value_ = q;
+  }
+  if (length > this->size_)
+    return;
+  while (this->size_ - this->used_ < length) {
+    uint32_t old_dt;
+    bool old_nan;
+    int32_t old_dq;
+    const uint8_t old_length = this->decode_(&old_dt, &old_nan, &old_dq);
+    this->pop_(old_length, old_dt, old_nan, old_dq);
+    this->dropped_++;
+  }
+  for (uint8_t i = 0; i < length; i++) {
+    this->data_[this->head_] = encoded[i];
+    this->head_ = this->head_ + 1 == this->size_ ? 0 : this->head_ + 1;
+  }
+  this->used_ += length;
+}
+
+uint8_t HistoryBuffer::read_varint_(uint16_t pos, uint32_t *value) const {
+  uint8_t length = 0;
+  *value = 0;
+  uint8_t byte;
+  do {
+    byte = this->data_[(pos + length) % this->size_];
+    *value |= uint32_t(byte & 0x7F) << (7 * length);
+    length++;
+  } while ((byte & 0x80) && length < 5);
+  return length;
+}
+
+uint8_t HistoryBuffer::decode_(uint32_t *dt, bool *nan, int32_t *dq) const {
+  uint32_t head;
+  uint8_t length = this->read_varint_(this->tail_, &head);
+  *dt = head >> 1;
+  *nan = head & 1;
+  *dq = 0;
+  if (!*nan) {
+    uint32_t zigzag;
+    length += this->read_varint_(this->tail_ + length, &zigzag);
+    *dq = int32_t(zigzag >> 1) ^ -int32_t(zigzag & 1);
+  }
+  return length;
+}
+
+void HistoryBuffer::pop_(uint8_t length, uint32_t dt, bool nan, int32_t dq) {
+  this->base_time_ += dt * TICK;
+  if (!nan)
+    this->base_value_ = int32_t(uint32_t(this->base_value_) + uint32_t(dq));
+  this->tail_ = (this->tail_ + length) % this->size_;
+  this->used_ -= length;
+}
+
+uint16_t HistoryBuffer::drain(uint32_t now, char *out, size_t out_size) {
+  size_t pos = 0;
+  uint16_t count = 0;
+  bool have_value = false;
+  out[0] = '\0';
+  while (this->used_ != 0) {
+    uint32_t dt;
+    bool nan;
+    int32_t dq;
+    const uint8_t length = this->decode_(&dt, &nan, &dq);
+    // The first time and the first real value are absolute, so every batch decodes on its own
+    const uint32_t time = count == 0 ? (now - (this->base_time_ + dt * TICK)) / TICK : dt;
+    const int32_t value = have_value ? dq : int32_t(uint32_t(this->base_value_) + uint32_t(dq));
+    char item[32];
+    const int written = nan ? snprintf(item, sizeof(item), "%s%" PRIu32 ":", count == 0 ? "" : ",", time)
+                            : snprintf(item, sizeof(item), "%s%" PRIu32 ":%" PRId32, count == 0 ? "" : ",", time, value);
+    if (written < 0 || pos + written >= out_size)
+      break;
+    memcpy(out + pos, item, written + 1);
+    pos += written;
+    this->pop_(length, dt, nan, dq);
+    have_value |= !nan;
+    count++;
+  }
+  return count;
+}
+
+}  // namespace fieldbus
+}  // namespace esphome
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace fieldbus {
+
+// Delta-encoded time series in caller-provided, fixed memory. Each sample is a varint of
+// the time since the previous sample (0.1 s units, low bit set for NAN) followed by the
+// zigzag varint change of the value, scaled to the sensor's accuracy_decimals: a slowly
+// changing value costs two bytes per sample. When full, the oldest samples are dropped.
+class HistoryBuffer {
+ public:
+  void init(uint8_t *storage, uint16_t size, int8_t decimals);
+  void record(uint32_t now, float value);
+
+  bool empty() const { return this->used_ == 0; }
+  uint16_t used() const { return this->used_; }
+  uint16_t size() const { return this->size_; }
+  uint32_t dropped() const { return this->dropped_; }
+  int8_t decimals() const { return this->decimals_; }
+  // Remove samples oldest first and write them to `out` as "age:value,dt:dv,...": the age
+  // of the first sample before `now`, then time deltas; the first real value is absolute,
+  // later ones are deltas, all scaled by 10^decimals; an empty value is NAN. Stops when
+  // `out` is full; returns the samples written.
+  uint16_t drain(uint32_t now, char *out, size_t out_size);
+
+ protected:
+  static constexpr uint32_t TICK = 100;  // ms per time unit
+
+  uint8_t read_varint_(uint16_t pos, uint32_t *value) const;
+  uint8_t decode_(uint32_t *dt, bool *nan, int32_t *dq) const;  // sample at tail_; returns its length
+  void pop_(uint8_t length, uint32_t dt, bool nan, int32_t dq);
+
+  uint8_t *data_{nullptr};
+  uint16_t size_{0};
+  uint16_t head_{0};  // next byte to write
+  uint16_t tail_{0};  // oldest sample
+  uint16_t used_{0};
+  int8_t decimals_{0};
+  float scale_{1.0f};
+  uint32_t base_time_{0};  // time and value the oldest sample is relative to
+  int32_t base_value_{0};
+  uint32_t last_time_{0};  // time and value the next sample is relative to
+  int32_t last_value_{0};
+  uint32_t dropped_{0};
+};
+
+}  // namespace fieldbus
+}  // namespace esphome
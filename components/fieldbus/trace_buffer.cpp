@@ -0,0 +1,33 @@
+#include "trace_buffer.h"
+#include "esphome/core/log.h"
+#include <cinttypes>
+
+namespace esphome {
+namespace fieldbus {
+
+static const char *const STATUS_NAMES[] = {"ok", "restored", "timeout", "short", "nack"};
+
+void TraceBuffer::flush(const char *tag, uint16_t max_events) {
+  const uint16_t capacity = this->events_.size();
+  if (this->overwritten_ != 0) {
+    ESP_LOGW(tag, "Trace: %" PRIu32 " events overwritten before they were logged", this->overwritten_);
+    this->overwritten_ = 0;
+  }
+  while (this->pending_ != 0 && max_events-- != 0) {
+    const uint16_t index = (this->head_ + capacity - this->pending_) % capacity;
+    const TraceEvent &event = this->events_[index];
+    ESP_LOGD(tag, "Trace %10" PRIu32 "ms #%u reg %u: %u (0x%04X) %s", event.timestamp, event.source, event.address, event.raw,
+             event.raw, STATUS_NAMES[event.status]);
+    this->pending_--;
+  }
+}
+
+void TraceBuffer::dump_config(const char *tag) const {
+  if (!this->is_enabled())
+    return;
+  ESP_LOGCONFIG(tag, "  Trace: %zu events%s, %u not logged yet", this->events_.size(),
+                this->lazy_flush_ ? ", logged while idle" : ", logged on request", this->pending_);
+}
+
+}  // namespace fieldbus
+}  // namespace esphome
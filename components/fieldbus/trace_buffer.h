@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace fieldbus {
+
+enum TraceStatus : uint8_t {
+  TRACE_OK = 0,
+  TRACE_RESTORED,  // value from flash, not from the bus
+  TRACE_TIMEOUT,
+  TRACE_SHORT_RESPONSE,
+  TRACE_NACK,
+};
+
+// One bus event, 12 bytes; `source` is whatever the component uses to tell its
+// transactions apart (read block, channel)
+struct TraceEvent {
+  uint32_t timestamp;  // millis()
+  uint16_t address;    // register
+  uint16_t raw;
+  TraceStatus status;
+  uint8_t source;
+};
+
+// Fixed-size RAM ring of binary bus events. Recording on the hot path is a struct copy; the
+// events are only turned into log lines later, a few at a time while the bus is idle, or
+// all at once on request. When full, the oldest unflushed events are overwritten.
+class TraceBuffer {
+ public:
+  static constexpr uint8_t FLUSH_BATCH = 4;
+
+  // Number of events kept; 0 disables tracing
+  void set_capacity(uint16_t capacity) { this->events_.resize(capacity); }
+  // Log FLUSH_BATCH events per idle loop() instead of waiting for dump()
+  void set_lazy_flush(bool lazy_flush) { this->lazy_flush_ = lazy_flush; }
+  bool is_enabled() const { return !this->events_.empty(); }
+
+  void record(uint8_t source, uint16_t address, uint16_t raw, TraceStatus status, uint32_t timestamp) {
+    const uint16_t capacity = this->events_.size();
+    if (capacity == 0)
+      return;
+    this->events_[this->head_] = {timestamp, address, raw, status, source};
+    this->head_ = this->head_ + 1 == capacity ? 0 : this->head_ + 1;
+    if (this->pending_ < capacity) {
+      this->pending_++;
+    } else {
+      this->overwritten_++;
+    }
+  }
+
+  // Called from an idle loop(); does nothing unless lazy flushing is on
+  void flush_idle(const char *tag) {
+    if (this->lazy_flush_ && this->pending_ != 0)
+      this->flush(tag, FLUSH_BATCH);
+  }
+  // Log up to max_events of the oldest unflushed events
+  void flush(const char *tag, uint16_t max_events);
+  void dump(const char *tag) { this->flush(tag, UINT16_MAX); }
+  void dump_config(const char *tag) const;
+
+ protected:
+  std::vector<TraceEvent> events_;
+  uint16_t head_{0};     // next slot to write
+  uint16_t pending_{0};  // recorded but not logged yet
+  uint32_t overwritten_{0};
+  bool lazy_flush_{true};
+};
+
+}  // namespace fieldbus
+}  // namespace esphome
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "esphome/core/automation.h"
+#include "m5stack420ma.h"
+
+namespace esphome {
+namespace m5stack420ma {
+
+// Calibrate one point of a channel's curve against the value the channel reads right now
+template<typename... Ts> class SetCalibrationPointAction : public Action<Ts...>, public Parented<M5Stack420MASensor> {
+ public:
+  TEMPLATABLE_VALUE(uint8_t, channel)
+  TEMPLATABLE_VALUE(uint8_t, point)
+  TEMPLATABLE_VALUE(float, value)
+
+  void play(Ts... x) override {
+    this->parent_->set_calibration_point(this->channel_.value(x...), this->point_.value(x...), this->value_.value(x...));
+  }
+};
+
+// Log every trace event not logged yet
+template<typename... Ts> class DumpTraceAction : public Action<Ts...>, public Parented<M5Stack420MASensor> {
+ public:
+  void play(Ts... x) override { this->parent_->dump_trace(); }
+};
+
+}  // namespace m5stack420ma
+}  // namespace esphome
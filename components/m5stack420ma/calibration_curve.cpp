@@ -0,0 +1,48 @@
+#include "calibration_curve.h"
+#include <algorithm>
+
+namespace esphome {
+namespace m5stack420ma {
+
+void CalibrationCurve::add_point(uint16_t raw, float value) {
+  if (this->count_ < MAX_POINTS)
+    this->points_[this->count_++] = {raw, value};
+}
+
+bool CalibrationCurve::set_point(uint8_t index, uint16_t raw, float value) {
+  if (index >= this->count_)
+    return false;
+  this->points_[index] = {raw, value};
+  return true;
+}
+
+void CalibrationCurve::build() {
+  std::sort(this->points_, this->points_ + this->count_,
+            [](const CalibrationPoint &a, const CalibrationPoint &b) { return a.raw < b.raw; });
+  for (uint8_t i = 0; i + 1 < this->count_; i++) {
+    const CalibrationPoint &a = this->points_[i];
+    const CalibrationPoint &b = this->points_[i + 1];
+    Segment &segment = this->segments_[i];
+    segment.raw = a.raw;
+    segment.value_q16 = static_cast<int64_t>(double(a.value) * 65536.0);
+    // Two points on the same raw value make a step, not a division by zero
+    const int32_t span = int32_t(b.raw) - int32_t(a.raw);
+    segment.slope_q24 = span == 0 ? 0 : static_cast<int64_t>(double(b.value - a.value) * 16777216.0 / span);
+  }
+}
+
+float CalibrationCurve::convert(uint16_t raw) const {
+  if (!this->is_valid())
+    return raw;
+  // Last segment starting at or below raw; the first one also covers values below it
+  uint8_t index = 0;
+  while (index + 2 < this->count_ && this->segments_[index + 1].raw <= raw)
+    index++;
+  const Segment &segment = this->segments_[index];
+  const int64_t delta = int32_t(raw) - int32_t(segment.raw);
+  const int64_t value_q16 = segment.value_q16 + ((delta * segment.slope_q24) >> 8);
+  return value_q16 * (1.0f / 65536.0f);
+}
+
+}  // namespace m5stack420ma
+}  // namespace esphome
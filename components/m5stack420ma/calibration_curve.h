@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+namespace m5stack420ma {
+
+struct CalibrationPoint {
+  uint16_t raw;  // register value: 0.01 mA for currents, counts for the 12-bit ADC
+  float value;   // engineering units
+};
+
+// Piecewise linear mapping from a raw register value to engineering units. Each segment is
+// precomputed into fixed-point offset and slope, so a conversion is a lookup, one integer
+// multiply-add and one float scale. Values outside the points extrapolate the end segments.
+class CalibrationCurve {
+ public:
+  static constexpr uint8_t MAX_POINTS = 8;
+
+  void add_point(uint16_t raw, float value);
+  // Replace point `index`; false if there is no such point
+  bool set_point(uint8_t index, uint16_t raw, float value);
+  void clear() { this->count_ = 0; }
+  // Sort the points and recompute the segments; call after changing points
+  void build();
+
+  bool is_valid() const { return this->count_ >= 2; }
+  uint8_t size() const { return this->count_; }
+  const CalibrationPoint &point(uint8_t index) const { return this->points_[index]; }
+  float convert(uint16_t raw) const;
+
+ protected:
+  struct Segment {
+    uint16_t raw;       // start of the segment
+    int64_t value_q16;  // value at `raw`, Q16
+    int64_t slope_q24;  // value per raw unit, Q24
+  };
+
+  CalibrationPoint points_[MAX_POINTS];
+  Segment segments_[MAX_POINTS - 1];
+  uint8_t count_{0};
+};
+
+}  // namespace m5stack420ma
+}  // namespace esphome
@@ -1,6 +1,10 @@
 #include "esphome.h"
 #include "esphome/core/log.h"
+#include "esphome/core/helpers.h"
 #include "m5stack420ma.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
 
 
 
@@ -12,73 +16,502 @@ static const char *TAG = "m5stack420ma.sensor";
 
 void M5Stack420MASensor::setup(){
   ESP_LOGCONFIG(TAG, "Setting up M5Stack 4-20mA Sensor...");
-  // Attempt to communicate with the sensor to ensure it's responding
-  uint8_t data[2];
-  if (!this->read_bytes(0x0, data, 1)) {
-    ESP_LOGE(TAG, "Failed to communicate with M5Stack 4-20mA sensor.");
-    mark_failed();
+  this->load_calibration_();
+  // The firmware version register doubles as the presence check. A module that is not
+  // there yet is probed with backoff instead of failing the component for good.
+  bool found = this->read_byte(FIRMWARE_VERSION_REG, &this->firmware_version_);
+  if (this->provision_from_ != 0 && this->provision_from_ != this->address_) {
+    // Provisioning happens at most once per address: after a module was seen there, a boot
+    // without it only probes
+    this->provision_pref_ = global_preferences->make_preference<uint8_t>(
+        fnv1_hash(str_sprintf("m5stack420ma_provisioned_%02X", this->address_)));
+    uint8_t provisioned = 0;
+    this->provision_pref_.load(&provisioned);
+    if (!found && provisioned == 0)
+      found = this->provision_();
+    if (found && provisioned == 0) {
+      provisioned = 1;
+      this->provision_pref_.save(&provisioned);
+    }
+  }
+  if (!found) {
+    ESP_LOGE(TAG, "Failed to communicate with M5Stack 4-20mA sensor at 0x%02X.", this->address_);
+    this->go_offline_();
+    return;
   }
-  ESP_LOGD(TAG, "Setup Status %u", data);
+  this->on_online_();
 }
 
-void M5Stack420MASensor::update(){
-  // Assuming you want to read from channel 0
-  float current_value = this->read_current(0);
-  uint16_t adc_12bit_value = this->read_adc_12bit(0);
-  ESP_LOGD(TAG, "Read current value: %u", current_value);
-  ESP_LOGD(TAG, "Read adc value: %u", adc_12bit_value);
+void M5Stack420MASensor::on_online_() {
+  ESP_LOGD(TAG, "Firmware version %u", this->firmware_version_);
+  this->schedule_device_calibration_();
+}
+
+// Too many failed transactions in a row: stop sampling, mark every channel unavailable
+// and only probe the module, with backoff, until it answers again
+void M5Stack420MASensor::go_offline_() {
+  ESP_LOGW(TAG, "Module at 0x%02X not responding; probing every %" PRIu32 "ms at most", this->address_,
+           MAX_PROBE_INTERVAL);
+  this->offline_ = true;
+  this->status_set_warning();
+  this->pending_work_ = (this->pending_work_ & ~(WORK_SAMPLE | WORK_ADC | WORK_CALIBRATE)) | WORK_PUBLISH;
+  this->attempts_ = 0;
+  this->probe_backoff_ = MIN_PROBE_INTERVAL;
+  this->next_probe_ = millis() + this->probe_backoff_;
+}
 
-  // Publish the current value
-  if (current_sensor_ != nullptr) {
-    current_sensor_->publish_state(current_value);
+void M5Stack420MASensor::probe_() {
+  if (this->read_byte(FIRMWARE_VERSION_REG, &this->firmware_version_)) {
+    ESP_LOGI(TAG, "Module at 0x%02X responding again", this->address_);
+    this->offline_ = false;
+    this->consecutive_failures_ = 0;
+    this->status_clear_warning();
+    this->on_online_();
+    return;
+  }
+  this->fieldbus_stats_.record_retry();
+  this->probe_backoff_ = std::min(this->probe_backoff_ * 2, MAX_PROBE_INTERVAL);
+  this->next_probe_ = millis() + this->probe_backoff_;
+  ESP_LOGD(TAG, "Module still not responding; next probe in %" PRIu32 "ms", this->probe_backoff_);
+}
+
+// A bus step succeeded or failed: failed steps stay pending and are retried after a short,
+// doubling pause within the same update, until max_retries is used up
+void M5Stack420MASensor::finish_step_(uint8_t work, bool ok) {
+  if (ok) {
+    this->attempts_ = 0;
+    this->consecutive_failures_ = 0;
+    this->pending_work_ &= ~work;
+    return;
+  }
+  if (++this->consecutive_failures_ >= this->offline_after_) {
+    this->go_offline_();
+    return;
   }
-  if (raw_adc_sensor_ != nullptr) {
-    raw_adc_sensor_->publish_state(adc_12bit_value);
+  if (this->attempts_ < this->max_retries_) {
+    this->fieldbus_stats_.record_retry();
+    this->retry_at_ = millis() + (RETRY_BACKOFF << this->attempts_);
+    this->attempts_++;
+    return;
   }
+  // Give up for this update; the affected channels are published as unavailable
+  this->attempts_ = 0;
+  this->pending_work_ &= ~work;
 }
 
-void M5Stack420MASensor::dump_config(){
-  ESP_LOGCONFIG(TAG, "M5Stack 4-20mA Sensor:");
-  // Additional config values can be logged here
+void M5Stack420MASensor::set_value_sensor(uint8_t channel, sensor::Sensor *value_sensor, bool from_adc) {
+  this->value_sensors_[channel] = value_sensor;
+  if (from_adc)
+    this->value_from_adc_ |= 1 << channel;
 }
 
+// Runtime points are only restored while the configured points are unchanged: the key
+// covers them, so editing the YAML starts over from it
+void M5Stack420MASensor::load_calibration_() {
+  std::string points = str_sprintf("m5stack420ma_cal_%02X", this->address_);
+  for (uint8_t ch = 0; ch < CHANNEL_COUNT; ch++) {
+    for (uint8_t i = 0; i < this->curves_[ch].size(); i++) {
+      const CalibrationPoint &point = this->curves_[ch].point(i);
+      points += str_sprintf(";%u:%u:%g", ch, point.raw, point.value);
+    }
+  }
+  this->calibration_pref_ = global_preferences->make_preference<CalibrationStore>(fnv1_hash(points));
+  if (this->calibration_pref_.load(&this->calibration_store_)) {
+    for (uint8_t ch = 0; ch < CHANNEL_COUNT; ch++) {
+      const uint8_t count = this->calibration_store_.count[ch];
+      if (count != this->curves_[ch].size())
+        continue;
+      for (uint8_t i = 0; i < count; i++) {
+        const CalibrationPoint &point = this->calibration_store_.points[ch][i];
+        this->curves_[ch].set_point(i, point.raw, point.value);
+      }
+    }
+  } else {
+    this->calibration_store_ = {};
+  }
+  for (auto &curve : this->curves_)
+    curve.build();
+}
 
+// The module keeps its calibration, so each reference current is written only once.
+// The writes are left to loop(), one per step.
+void M5Stack420MASensor::schedule_device_calibration_() {
+  this->calibration_pending_ = 0;
+  for (uint8_t ch = 0; ch < CHANNEL_COUNT; ch++) {
+    const uint16_t reference = this->device_calibration_[ch];
+    if (reference != 0 && this->calibration_store_.device_calibration[ch] != reference)
+      this->calibration_pending_ |= 1 << ch;
+  }
+  if (this->calibration_pending_ != 0)
+    this->pending_work_ |= WORK_CALIBRATE;
+}
 
-float M5Stack420MASensor::read_current(uint8_t channel) {
-  uint8_t reg = MODULE_4_20MA_CURRENT_REG;
-  uint8_t data[2] = {0};
-  if (!this->read_bytes(reg, data, 2)) {
-    ESP_LOGW(TAG, "Failed to read current value");
-    return 0;
+// The module stores a reference current before it answers again, so each write is followed
+// by CALIBRATION_SETTLE without bus access, as the reference driver waits after setCalCurrent.
+// A failed write is tried again the next time the module comes online.
+void M5Stack420MASensor::calibrate_step_() {
+  uint8_t ch = 0;
+  while ((this->calibration_pending_ & (1 << ch)) == 0)
+    ch++;
+  this->calibration_pending_ &= ~(1 << ch);
+  if (this->calibration_pending_ == 0)
+    this->pending_work_ &= ~WORK_CALIBRATE;
+  const uint16_t reference = this->device_calibration_[ch];
+  if (this->calibrate(ch, reference)) {
+    this->calibration_store_.device_calibration[ch] = reference;
+    this->calibration_pref_.save(&this->calibration_store_);
   }
-  uint16_t current_raw = uint16_t(data[0]) | (uint16_t(data[1]) << 8);
-  float current = current_raw / 100.0;
-  ESP_LOGD(TAG, "Raw current: %u, Converted current: %.2f mA", current_raw, current);
-  return current;
+  this->settling_ = true;
+  this->settle_start_ = millis();
+}
+
+bool M5Stack420MASensor::set_calibration_point(uint8_t channel, uint8_t index, float value) {
+  if (channel >= CHANNEL_COUNT)
+    return false;
+  const bool from_adc = this->value_from_adc_ & (1 << channel);
+  const uint16_t raw = from_adc ? this->adc_values_[channel] : this->last_current_[channel];
+  CalibrationCurve &curve = this->curves_[channel];
+  if (!curve.set_point(index, raw, value)) {
+    ESP_LOGW(TAG, "Channel %u has no calibration point %u", channel, index);
+    return false;
+  }
+  ESP_LOGI(TAG, "Channel %u calibration point %u: raw %u -> %g", channel, index, raw, value);
+  const uint8_t count = curve.size();
+  this->calibration_store_.count[channel] = count;
+  for (uint8_t i = 0; i < count; i++)
+    this->calibration_store_.points[channel][i] = curve.point(i);
+  curve.build();
+  this->calibration_pref_.save(&this->calibration_store_);
+  return true;
+}
+
+// A new module still answers at its factory address: move it to the configured one. Only
+// one unprovisioned module may be on the bus at a time, as all of them share that address.
+// Runs once, from setup(); a module that drops off the bus later is only probed, so a
+// healthy module at provision_from is never moved.
+bool M5Stack420MASensor::provision_() {
+  const uint8_t target = this->address_;
+  this->set_i2c_address(this->provision_from_);
+  if (!this->read_byte(FIRMWARE_VERSION_REG, &this->firmware_version_)) {
+    this->set_i2c_address(target);
+    return false;
+  }
+  ESP_LOGI(TAG, "Assigning address 0x%02X to the module at 0x%02X", target, this->provision_from_);
+  const bool written = this->write_byte(I2C_ADDRESS_REG, target);
+  this->set_i2c_address(target);
+  if (!written)
+    return false;
+  delay(10);  // the module re-initialises its I2C peripheral
+  return this->read_byte(FIRMWARE_VERSION_REG, &this->firmware_version_);
+}
+
+void M5Stack420MASensor::set_filter(FilterType type, uint8_t window_size, uint8_t trim, float ema_alpha) {
+  const uint16_t alpha_q15 = static_cast<uint16_t>(ema_alpha * 32768.0f + 0.5f);
+  for (auto &filter : this->filters_)
+    filter.configure(type, window_size, trim, alpha_q15);
+}
+
+// I2C work runs here as a state machine, at most one bus transaction per loop iteration,
+// unless a ModulePoller shares the bus with other modules and steps this one itself.
+void M5Stack420MASensor::loop() {
+  const uint32_t now = millis();
+  if (this->offline_) {
+    if (static_cast<int32_t>(now - this->next_probe_) >= 0)
+      this->pending_work_ |= WORK_PROBE;
+  } else if (this->sample_interval_ != 0 && now - this->last_sample_ >= this->sample_interval_) {
+    this->last_sample_ = now;
+    this->pending_work_ |= WORK_SAMPLE;
+  }
+  if (this->pending_work_ == 0)
+    this->trace_.flush_idle(TAG);
+  // Modules sharing a poller have their bus work done by it
+  if (this->poller_ != nullptr || this->pending_work_ == 0)
+    return;
+  const uint32_t start = micros();
+  if (this->has_bus_work())
+    this->run_bus_step();
+  this->publish_if_ready(start);
+}
+
+// One bus transaction. Calibration goes first, and the ADC read (once per update) goes
+// before samples so fast oversampling cannot starve it.
+void M5Stack420MASensor::run_bus_step() {
+  const uint32_t start = micros();
+  this->settling_ = false;
+  if (this->pending_work_ & WORK_PROBE) {
+    this->pending_work_ &= ~WORK_PROBE;
+    this->probe_();
+  } else if (this->pending_work_ & WORK_CALIBRATE) {
+    this->calibrate_step_();
+  } else if (this->pending_work_ & WORK_ADC) {
+    this->finish_step_(WORK_ADC, this->read_adcs_());
+  } else if (this->pending_work_ & WORK_SAMPLE) {
+    this->finish_step_(WORK_SAMPLE, this->sample_currents_());
+  }
+  this->note_stall_(micros() - start);
+}
+
+// Publishing needs no bus access and runs while the loop() iteration is within budget.
+// Without oversampling it waits for the sample update() asked for.
+void M5Stack420MASensor::publish_if_ready(uint32_t loop_start) {
+  const uint8_t blocking = WORK_ADC | (this->sample_interval_ == 0 ? WORK_SAMPLE : 0);
+  if ((this->pending_work_ & WORK_PUBLISH) == 0 || (this->pending_work_ & blocking) != 0 ||
+      micros() - loop_start >= this->loop_budget_)
+    return;
+  const uint32_t start = micros();
+  this->pending_work_ &= ~WORK_PUBLISH;
+  this->publish_();
+  this->note_stall_(micros() - start);
+}
+
+bool M5Stack420MASensor::has_bus_work() const {
+  if (this->is_failed())
+    return false;
+  if (this->settling_ && millis() - this->settle_start_ < CALIBRATION_SETTLE)
+    return false;
+  if (this->pending_work_ & (WORK_PROBE | WORK_CALIBRATE))
+    return true;
+  // A failed step waits out its retry pause
+  return (this->pending_work_ & (WORK_SAMPLE | WORK_ADC)) != 0 &&
+         (this->attempts_ == 0 || static_cast<int32_t>(millis() - this->retry_at_) >= 0);
 }
 
-uint16_t M5Stack420MASensor::read_adc_12bit(uint8_t channel) {
-  uint8_t reg = MODULE_4_20MA_ADC_12BIT_REG;
-  uint8_t data[2] = {0};
-  if (!this->read_bytes(reg, data, 2)) {
-    ESP_LOGW(TAG, "Failed to read raw adc value");
-    return 0;
+void M5Stack420MASensor::dump_trace() { this->trace_.dump(TAG); }
+
+void M5Stack420MASensor::note_stall_(uint32_t stall) {
+  this->stall_max_ = std::max(this->stall_max_, stall);
+  this->stall_worst_ = std::max(this->stall_worst_, stall);
+}
+
+// Channel registers are contiguous (reg + channel * 2), so each register kind is fetched
+// for all enabled channels in a single burst, however many channels are configured
+bool M5Stack420MASensor::sample_currents_() {
+  uint16_t values[CHANNEL_COUNT];
+  uint8_t first = CHANNEL_COUNT, last = 0;
+  for (uint8_t ch = 0; ch < CHANNEL_COUNT; ch++) {
+    if (this->samples_current_(ch)) {
+      first = std::min(first, ch);
+      last = std::max(last, ch);
+    }
+  }
+  for (auto *alarm : this->alarms_) {
+    first = std::min(first, alarm->get_channel());
+    last = std::max(last, alarm->get_channel());
+  }
+  if (first > last)
+    return true;
+  if (!this->read_channels_(MODULE_4_20MA_CURRENT_REG, first, last, values))
+    return false;
+  for (uint8_t ch = first; ch <= last; ch++) {
+    if (this->samples_current_(ch))
+      this->filters_[ch].push(values[ch - first]);
+  }
+  // Alarms see the unfiltered sample straight away, independent of the publish rate
+  for (auto *alarm : this->alarms_) {
+    const uint8_t ch = alarm->get_channel();
+    if (ch >= first && ch <= last)
+      alarm->evaluate(values[ch - first]);
+  }
+  return true;
+}
+
+// Only schedules the work; loop() performs it
+void M5Stack420MASensor::update(){
+  this->update_started_us_ = micros();
+  this->pending_work_ |= WORK_PUBLISH;
+  if (this->offline_)
+    return;
+  // Without oversampling the filters see exactly one sample per update
+  if (this->sample_interval_ == 0)
+    this->pending_work_ |= WORK_SAMPLE;
+  uint8_t first, last;
+  if (this->adc_range_(&first, &last))
+    this->pending_work_ |= WORK_ADC;
+}
+
+bool M5Stack420MASensor::read_adcs_() {
+  uint8_t first, last;
+  if (!this->adc_range_(&first, &last))
+    return true;
+  uint16_t values[CHANNEL_COUNT];
+  if (!this->read_channels_(MODULE_4_20MA_ADC_12BIT_REG, first, last, values))
+    return false;
+  for (uint8_t ch = first; ch <= last; ch++) {
+    this->adc_values_[ch] = values[ch - first];
+    this->adc_fresh_ |= 1 << ch;
+  }
+  return true;
+}
+
+void M5Stack420MASensor::publish_() {
+  for (uint8_t ch = 0; ch < CHANNEL_COUNT; ch++) {
+    uint16_t raw;
+    const uint8_t bit = 1 << ch;
+    if (!this->samples_current_(ch))
+      continue;
+    if (!this->filters_[ch].take(&raw)) {
+      // No good sample since the last publish: unavailable rather than a fake 0 mA
+      if (this->current_valid_ & bit) {
+        ESP_LOGW(TAG, "Channel %u current unavailable", ch);
+        this->current_valid_ &= ~bit;
+        if (this->current_sensors_[ch] != nullptr)
+          this->current_sensors_[ch]->publish_state(NAN);
+        if (this->value_sensors_[ch] != nullptr && (this->value_from_adc_ & bit) == 0)
+          this->value_sensors_[ch]->publish_state(NAN);
+      }
+      continue;
+    }
+    this->current_valid_ |= bit;
+    this->last_current_[ch] = raw;
+    float current = raw * 0.01f;
+    if (!this->trace_.is_enabled())
+      ESP_LOGD(TAG, "Channel %u current: %.2f mA (raw %u)", ch, current, raw);
+    if (this->current_sensors_[ch] != nullptr)
+      this->current_sensors_[ch]->publish_state(current);
+    if (this->value_sensors_[ch] != nullptr && (this->value_from_adc_ & (1 << ch)) == 0)
+      this->value_sensors_[ch]->publish_state(this->curves_[ch].convert(raw));
+  }
+  for (uint8_t ch = 0; ch < CHANNEL_COUNT; ch++) {
+    const uint8_t bit = 1 << ch;
+    const bool value_from_adc = this->value_sensors_[ch] != nullptr && (this->value_from_adc_ & bit) != 0;
+    if (this->raw_adc_sensors_[ch] == nullptr && !value_from_adc)
+      continue;
+    if ((this->adc_fresh_ & bit) == 0) {
+      if (this->adc_valid_ & bit) {
+        ESP_LOGW(TAG, "Channel %u ADC unavailable", ch);
+        this->adc_valid_ &= ~bit;
+        if (this->raw_adc_sensors_[ch] != nullptr)
+          this->raw_adc_sensors_[ch]->publish_state(NAN);
+        if (value_from_adc)
+          this->value_sensors_[ch]->publish_state(NAN);
+      }
+      continue;
+    }
+    this->adc_valid_ |= bit;
+    if (this->raw_adc_sensors_[ch] != nullptr) {
+      if (!this->trace_.is_enabled())
+        ESP_LOGD(TAG, "Channel %u ADC: %u", ch, this->adc_values_[ch]);
+      this->raw_adc_sensors_[ch]->publish_state(this->adc_values_[ch]);
+    }
+    if (value_from_adc)
+      this->value_sensors_[ch]->publish_state(this->curves_[ch].convert(this->adc_values_[ch]));
+  }
+  this->adc_fresh_ = 0;
+
+  ESP_LOGV(TAG, "Longest loop() since last update: %" PRIu32 "us (worst %" PRIu32 "us)", this->stall_max_,
+           this->stall_worst_);
+  if (this->loop_time_sensor_ != nullptr)
+    this->loop_time_sensor_->publish_state(this->stall_max_);
+  this->stall_max_ = 0;
+  this->fieldbus_stats_.record_cycle(micros() - this->update_started_us_);
+  this->fieldbus_stats_.publish();
+  ESP_LOGV(TAG, "Bus transactions this update: %u", this->update_transactions_);
+  this->update_transactions_max_ = std::max(this->update_transactions_max_, this->update_transactions_);
+  this->update_transactions_ = 0;
+}
+
+bool M5Stack420MASensor::channel_range_(sensor::Sensor *const *sensors, uint8_t *first, uint8_t *last) {
+  bool any = false;
+  for (uint8_t ch = 0; ch < CHANNEL_COUNT; ch++) {
+    if (sensors[ch] == nullptr)
+      continue;
+    if (!any)
+      *first = ch;
+    *last = ch;
+    any = true;
+  }
+  return any;
+}
+
+// ADC channels with a raw sensor or an engineering value converted from the ADC
+bool M5Stack420MASensor::adc_range_(uint8_t *first, uint8_t *last) const {
+  bool any = channel_range_(this->raw_adc_sensors_, first, last);
+  for (uint8_t ch = 0; ch < CHANNEL_COUNT; ch++) {
+    if (this->value_sensors_[ch] == nullptr || (this->value_from_adc_ & (1 << ch)) == 0)
+      continue;
+    *first = any ? std::min(*first, ch) : ch;
+    *last = any ? std::max(*last, ch) : ch;
+    any = true;
+  }
+  return any;
+}
+
+bool M5Stack420MASensor::read_channels_(uint8_t base_reg, uint8_t first, uint8_t last, uint16_t *values) {
+  uint8_t data[CHANNEL_COUNT * 2];
+  const uint8_t count = last - first + 1;
+  const uint32_t start = micros();
+  if (this->update_transactions_ < UINT8_MAX)
+    this->update_transactions_++;
+  const i2c::ErrorCode err = this->read_register(base_reg + first * 2, data, count * 2);
+  if (err != i2c::ERROR_OK) {
+    const bool timeout = err == i2c::ERROR_TIMEOUT;
+    this->fieldbus_stats_.record_error(timeout ? fieldbus::ERROR_TIMEOUT : fieldbus::ERROR_NACK);
+    this->trace_.record(first, base_reg + first * 2, 0, timeout ? fieldbus::TRACE_TIMEOUT : fieldbus::TRACE_NACK,
+                        millis());
+    // With a trace buffer the failure is in the trace already
+    if (!this->trace_.is_enabled())
+      ESP_LOGW(TAG, "Failed to read registers 0x%02X..0x%02X", base_reg + first * 2, base_reg + last * 2 + 1);
+    return false;
+  }
+  this->fieldbus_stats_.record_transaction(base_reg == MODULE_4_20MA_CURRENT_REG ? STATS_CURRENT : STATS_ADC,
+                                           micros() - start);
+  const uint32_t now = millis();
+  for (uint8_t i = 0; i < count; i++) {
+    values[i] = uint16_t(data[i * 2]) | (uint16_t(data[i * 2 + 1]) << 8);
+    this->trace_.record(first + i, base_reg + (first + i) * 2, values[i], fieldbus::TRACE_OK, now);
+  }
+  return true;
+}
+
+void M5Stack420MASensor::dump_config(){
+  ESP_LOGCONFIG(TAG, "M5Stack 4-20mA Sensor:");
+  LOG_I2C_DEVICE(this);
+  ESP_LOGCONFIG(TAG, "  Firmware version: %u%s", this->firmware_version_, this->offline_ ? " (offline)" : "");
+  ESP_LOGCONFIG(TAG, "  Retries: %u per read, offline after %u failed reads in a row", this->max_retries_,
+                this->offline_after_);
+  if (this->provision_from_ != 0)
+    ESP_LOGCONFIG(TAG, "  Provisioning new modules from address 0x%02X", this->provision_from_);
+  LOG_UPDATE_INTERVAL(this);
+  if (this->sample_interval_ != 0)
+    ESP_LOGCONFIG(TAG, "  Oversampling every %" PRIu32 "ms", this->sample_interval_);
+  ESP_LOGCONFIG(TAG, "  Loop budget: %" PRIu32 "us, longest step so far: %" PRIu32 "us", this->loop_budget_,
+                this->stall_worst_);
+  LOG_SENSOR("  ", "Loop Time", this->loop_time_sensor_);
+  for (uint8_t ch = 0; ch < CHANNEL_COUNT; ch++) {
+    if (this->current_sensors_[ch] != nullptr || this->raw_adc_sensors_[ch] != nullptr ||
+        this->value_sensors_[ch] != nullptr)
+      ESP_LOGCONFIG(TAG, "  Channel %u:", ch);
+    LOG_SENSOR("    ", "Current", this->current_sensors_[ch]);
+    LOG_SENSOR("    ", "Raw ADC", this->raw_adc_sensors_[ch]);
+    LOG_SENSOR("    ", "Value", this->value_sensors_[ch]);
+    const CalibrationCurve &curve = this->curves_[ch];
+    for (uint8_t i = 0; i < curve.size(); i++)
+      ESP_LOGCONFIG(TAG, "      Calibration point %u: raw %u -> %g", i, curve.point(i).raw, curve.point(i).value);
+    if (this->device_calibration_[ch] != 0)
+      ESP_LOGCONFIG(TAG, "      Device calibration: %.2f mA", this->device_calibration_[ch] * 0.01f);
   }
-  uint16_t adc = uint16_t(data[0]) | (uint16_t(data[1]) << 8);
-  return adc;
+  for (auto *alarm : this->alarms_)
+    alarm->dump_config(TAG);
+  this->fieldbus_stats_.dump_config(TAG);
+  this->trace_.dump_config(TAG);
+  ESP_LOGCONFIG(TAG, "    Most transactions in one update: %u", this->update_transactions_max_);
+  this->fieldbus_stats_.kind(STATS_CURRENT).dump(TAG, "Current burst");
+  this->fieldbus_stats_.kind(STATS_ADC).dump(TAG, "ADC burst");
 }
 
-void M5Stack420MASensor::calibrate(uint16_t calibration_value) {
+// Tells the module the current (0.01 mA) flowing in the channel right now
+bool M5Stack420MASensor::calibrate(uint8_t channel, uint16_t calibration_value) {
     uint8_t data[2];
     data[0] = calibration_value & 0xFF;        // Low byte
     data[1] = (calibration_value >> 8) & 0xFF; // High byte
 
-    // Write to the calibration registers
-    if (!this->write_bytes(0x30, data, 2)) {
+    // Write to the channel's calibration register
+    if (!this->write_bytes(MODULE_4_20MA_CAL_REG + channel * 2, data, 2)) {
         ESP_LOGW(TAG, "Failed to write calibration value");
-    } else {
-        ESP_LOGD(TAG, "Calibration successful, written value: %u", calibration_value);
+        return false;
     }
+    ESP_LOGD(TAG, "Channel %u calibration successful, written value: %u", channel, calibration_value);
+    return true;
 }
 
 void M5Stack420MASensor::test() {
@@ -1,8 +1,16 @@
 #pragma once
 
 #include "esphome/core/component.h"
+#include "esphome/core/preferences.h"
 #include "esphome/components/sensor/sensor.h"
 #include "esphome/components/i2c/i2c.h"
+#include "esphome/components/fieldbus/fieldbus_stats.h"
+#include "esphome/components/fieldbus/trace_buffer.h"
+#include "sample_filter.h"
+#include "calibration_curve.h"
+#include "threshold_alarm.h"
+#include "module_poller.h"
+#include <vector>
 
 
 #define MODULE_4_20MA_ADDR          0x55
@@ -18,27 +26,164 @@
 namespace esphome {
 namespace m5stack420ma {
 
+static constexpr uint8_t CHANNEL_COUNT = 4;
+static constexpr uint32_t RETRY_BACKOFF = 2;            // ms before the first retry, doubling
+static constexpr uint32_t MIN_PROBE_INTERVAL = 1000;    // ms, while offline, doubling
+static constexpr uint32_t MAX_PROBE_INTERVAL = 60000;
+static constexpr uint32_t CALIBRATION_SETTLE = 500;     // ms without bus access after a CAL_REG write
+
+// Work scheduled for loop(); each I2C step is one transaction
+enum WorkFlag : uint8_t {
+  WORK_SAMPLE = 1 << 0,     // burst-read the current registers
+  WORK_ADC = 1 << 1,        // burst-read the 12-bit ADC registers
+  WORK_PUBLISH = 1 << 2,    // publish filtered currents and ADC values, no bus access
+  WORK_PROBE = 1 << 3,      // offline: check whether the module answers again
+  WORK_CALIBRATE = 1 << 4,  // write one channel's reference current to its CAL_REG
+};
+
+// Calibration kept across reboots: points changed at runtime and the reference currents
+// already written to the module's CAL_REG
+struct CalibrationStore {
+  uint16_t device_calibration[CHANNEL_COUNT];
+  uint8_t count[CHANNEL_COUNT];
+  CalibrationPoint points[CHANNEL_COUNT][CalibrationCurve::MAX_POINTS];
+};
+
+// Transaction kinds with their own latency histogram
+enum StatsKind : uint8_t {
+  STATS_CURRENT = 0,  // current register burst
+  STATS_ADC,          // 12-bit ADC register burst
+  STATS_KIND_COUNT,
+};
+
 class M5Stack420MASensor : public sensor::Sensor, public PollingComponent, public i2c::I2CDevice {
   public:
-    M5Stack420MASensor() = default;
+    M5Stack420MASensor() { this->fieldbus_stats_.set_kind_count(STATS_KIND_COUNT); }
     
-    void set_current_sensor(sensor::Sensor *current_sensor) { this->current_sensor_ = current_sensor; }
-    void set_raw_adc_sensor(sensor::Sensor *raw_adc_sensor) { this->raw_adc_sensor_ = raw_adc_sensor; }
+    void set_current_sensor(uint8_t channel, sensor::Sensor *current_sensor) { this->current_sensors_[channel] = current_sensor; }
+    void set_raw_adc_sensor(uint8_t channel, sensor::Sensor *raw_adc_sensor) { this->raw_adc_sensors_[channel] = raw_adc_sensor; }
+    // Engineering value of a channel, converted from its filtered current or its ADC value
+    void set_value_sensor(uint8_t channel, sensor::Sensor *value_sensor, bool from_adc);
+    void add_calibration_point(uint8_t channel, uint16_t raw, float value) { this->curves_[channel].add_point(raw, value); }
+    // Reference current (0.01 mA) applied when the module is first set up; written to its
+    // CAL_REG once, the module keeps it
+    void set_device_calibration(uint8_t channel, uint16_t raw) { this->device_calibration_[channel] = raw; }
+    // Make point `index` of the channel's curve map the last published raw value to `value`
+    bool set_calibration_point(uint8_t channel, uint8_t index, float value);
+    // Oversampling: read the current registers every sample_interval and publish the
+    // filtered value at update_interval; 0 reads once per update()
+    void set_sample_interval(uint32_t sample_interval) { this->sample_interval_ = sample_interval; }
+    void set_filter(FilterType type, uint8_t window_size, uint8_t trim, float ema_alpha);
+    // Checked against every raw current sample of its channel
+    void add_alarm(ThresholdAlarm *alarm) { this->alarms_.push_back(alarm); }
+    // Skip non-bus work in a loop() iteration that has already run this long (us)
+    void set_loop_budget(uint32_t loop_budget) { this->loop_budget_ = loop_budget; }
+    // Longest time this module held loop() since the last update, in us
+    void set_loop_time_sensor(sensor::Sensor *sensor) { this->loop_time_sensor_ = sensor; }
+    // Retry a failed read this often within one update
+    void set_max_retries(uint8_t max_retries) { this->max_retries_ = max_retries; }
+    // Stop sampling and probe with backoff after this many failed reads in a row
+    void set_offline_after(uint8_t offline_after) { this->offline_after_ = offline_after; }
+    // Address a new module answers at before provisioning; 0 disables provisioning. A module
+    // is provisioned at most once, at boot; a flag in flash remembers it is done.
+    void set_provision_from(uint8_t address) { this->provision_from_ = address; }
+    // Let a bus-wide poller do this module's I2C work
+    void set_poller(ModulePoller *poller) {
+      this->poller_ = poller;
+      poller->add_module(this);
+    }
+
+    // Latency per register kind, NACKs and update-to-publish cycle times
+    fieldbus::FieldbusStats &get_fieldbus_stats() { return this->fieldbus_stats_; }
+    // With a trace buffer, register reads are recorded as binary events instead of logged
+    fieldbus::TraceBuffer &get_trace() { return this->trace_; }
+    void dump_trace();
 
-    void calibrate(uint16_t calibration_value);
+    bool has_bus_work() const;
+    void run_bus_step();
+    void publish_if_ready(uint32_t loop_start);
+
+    bool calibrate(uint8_t channel, uint16_t calibration_value);
 
     void test();
 
     void setup() override;
     void update() override;
+    void loop() override;
     void dump_config() override;
-  
-    float read_current(uint8_t channel);
-    uint16_t read_adc_12bit(uint8_t channel);
 
   protected:
-    sensor::Sensor *current_sensor_{nullptr};
-    sensor::Sensor *raw_adc_sensor_{nullptr};
+    // Read the 16-bit little-endian registers of channels first..last in one transaction
+    bool read_channels_(uint8_t base_reg, uint8_t first, uint8_t last, uint16_t *values);
+    // Channels with a sensor in `sensors`; false if none
+    static bool channel_range_(sensor::Sensor *const *sensors, uint8_t *first, uint8_t *last);
+    bool adc_range_(uint8_t *first, uint8_t *last) const;
+    // The channel's current is filtered for its current sensor or its engineering value
+    bool samples_current_(uint8_t ch) const {
+      return this->current_sensors_[ch] != nullptr ||
+             (this->value_sensors_[ch] != nullptr && (this->value_from_adc_ & (1 << ch)) == 0);
+    }
+    bool sample_currents_();
+    bool read_adcs_();
+    void finish_step_(uint8_t work, bool ok);
+    void go_offline_();
+    void probe_();
+    void on_online_();
+    void schedule_device_calibration_();
+    void calibrate_step_();
+    void publish_();
+    bool provision_();
+    void load_calibration_();
+    void note_stall_(uint32_t stall);
+
+    sensor::Sensor *current_sensors_[CHANNEL_COUNT]{};
+    sensor::Sensor *raw_adc_sensors_[CHANNEL_COUNT]{};
+    sensor::Sensor *value_sensors_[CHANNEL_COUNT]{};
+    uint8_t value_from_adc_{0};  // channel bits converting the ADC value instead of the current
+
+    CalibrationCurve curves_[CHANNEL_COUNT];
+    uint16_t device_calibration_[CHANNEL_COUNT]{};
+    uint16_t last_current_[CHANNEL_COUNT]{};  // last published raw current per channel
+    CalibrationStore calibration_store_{};
+    ESPPreferenceObject calibration_pref_;
+    uint8_t calibration_pending_{0};  // channel bits whose CAL_REG is still to be written
+    bool settling_{false};            // a CAL_REG write at settle_start_ is being stored
+    uint32_t settle_start_{0};
+
+    uint32_t sample_interval_{0};
+    uint32_t last_sample_{0};
+    SampleFilter filters_[CHANNEL_COUNT];
+    std::vector<ThresholdAlarm *> alarms_;
+
+    uint8_t pending_work_{0};  // WorkFlag bits
+    uint16_t adc_values_[CHANNEL_COUNT]{};
+    uint8_t adc_fresh_{0};     // channel bits read since the last publish
+    uint8_t current_valid_{0x0F};  // channel bits last published as a real value
+    uint8_t adc_valid_{0x0F};
+
+    uint8_t max_retries_{2};
+    uint8_t offline_after_{5};
+    uint8_t attempts_{0};              // failed tries of the pending bus step
+    uint8_t consecutive_failures_{0};  // failed bus steps in a row
+    uint32_t retry_at_{0};
+    bool offline_{false};
+    uint32_t probe_backoff_{MIN_PROBE_INTERVAL};
+    uint32_t next_probe_{0};
+    uint32_t loop_budget_{2000};
+    uint32_t stall_max_{0};    // longest step since the last publish, us
+    uint32_t stall_worst_{0};  // longest step since boot, us
+    sensor::Sensor *loop_time_sensor_{nullptr};
+
+    fieldbus::FieldbusStats fieldbus_stats_;
+    fieldbus::TraceBuffer trace_;
+    uint32_t update_started_us_{0};
+    uint8_t update_transactions_{0};      // bus transactions since the last publish
+    uint8_t update_transactions_max_{0};  // most transactions one update needed
+
+    ModulePoller *poller_{nullptr};
+    uint8_t provision_from_{0};
+    ESPPreferenceObject provision_pref_;  // non-zero once the module is at its address
+    uint8_t firmware_version_{0};
 
 
   private:
@@ -0,0 +1,37 @@
+#include "module_poller.h"
+#include "m5stack420ma.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+#include <algorithm>
+#include <cinttypes>
+
+namespace esphome {
+namespace m5stack420ma {
+
+static const char *const TAG = "m5stack420ma.poller";
+
+void ModulePoller::loop() {
+  const uint32_t start = micros();
+  const size_t count = this->modules_.size();
+  for (size_t i = 0; i < count; i++) {
+    const size_t index = (this->next_ + i) % count;
+    auto *module = this->modules_[index];
+    if (module->has_bus_work()) {
+      module->run_bus_step();
+      this->next_ = index + 1;
+      break;
+    }
+  }
+  // Publishing needs no bus access; every module that is ready gets it while the budget allows
+  for (auto *module : this->modules_)
+    module->publish_if_ready(start);
+  this->stall_worst_ = std::max(this->stall_worst_, micros() - start);
+}
+
+void ModulePoller::dump_config() {
+  ESP_LOGCONFIG(TAG, "M5Stack 4-20mA poller:");
+  ESP_LOGCONFIG(TAG, "  Modules: %zu, worst loop() so far: %" PRIu32 "us", this->modules_.size(), this->stall_worst_);
+}
+
+}  // namespace m5stack420ma
+}  // namespace esphome
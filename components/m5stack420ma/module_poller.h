@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace m5stack420ma {
+
+class M5Stack420MASensor;
+
+// Services every 4-20 mA module on one I2C bus from a single loop(): one burst read per
+// iteration, handed round-robin to the modules with bus work, so the time spent per
+// iteration does not grow with the number of modules.
+class ModulePoller : public Component {
+ public:
+  void add_module(M5Stack420MASensor *module) { this->modules_.push_back(module); }
+
+  void loop() override;
+  void dump_config() override;
+  float get_setup_priority() const override { return setup_priority::DATA; }
+
+ protected:
+  std::vector<M5Stack420MASensor *> modules_;
+  size_t next_{0};
+  uint32_t stall_worst_{0};  // longest loop() since boot, us
+};
+
+}  // namespace m5stack420ma
+}  // namespace esphome
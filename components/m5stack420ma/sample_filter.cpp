@@ -0,0 +1,67 @@
+#include "sample_filter.h"
+#include <algorithm>
+
+namespace esphome {
+namespace m5stack420ma {
+
+void SampleFilter::configure(FilterType type, uint8_t window_size, uint8_t trim, uint16_t ema_alpha_q15) {
+  this->type_ = type;
+  this->window_size_ = std::min<uint8_t>(std::max<uint8_t>(window_size, 1), MAX_WINDOW);
+  // Always keep at least one sample after trimming
+  this->trim_ = std::min<uint8_t>(trim, (this->window_size_ - 1) / 2);
+  this->ema_alpha_ = ema_alpha_q15;
+}
+
+void SampleFilter::push(uint16_t sample) {
+  this->ring_[this->head_] = sample;
+  this->head_ = (this->head_ + 1) % this->window_size_;
+  if (this->count_ < this->window_size_)
+    this->count_++;
+  this->fresh_ = true;
+}
+
+bool SampleFilter::take(uint16_t *value) {
+  if (!this->fresh_)
+    return false;
+  this->fresh_ = false;
+  const int32_t x_q8 = int32_t(this->reduce_()) << 8;
+  if (!this->ema_valid_) {
+    this->ema_q8_ = x_q8;
+    this->ema_valid_ = true;
+  } else {
+    this->ema_q8_ += static_cast<int32_t>((int64_t(this->ema_alpha_) * (x_q8 - this->ema_q8_)) >> 15);
+  }
+  *value = static_cast<uint16_t>((this->ema_q8_ + 128) >> 8);
+  return true;
+}
+
+uint16_t SampleFilter::reduce_() const {
+  uint16_t sorted[MAX_WINDOW];
+  const uint8_t n = this->count_;
+  std::copy(this->ring_, this->ring_ + n, sorted);
+  if (this->type_ == FILTER_MEAN) {
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < n; i++)
+      sum += sorted[i];
+    return (sum + n / 2) / n;
+  }
+  // Insertion sort: at most MAX_WINDOW samples, mostly nearly sorted noise around a level
+  for (uint8_t i = 1; i < n; i++) {
+    const uint16_t v = sorted[i];
+    uint8_t j = i;
+    for (; j > 0 && sorted[j - 1] > v; j--)
+      sorted[j] = sorted[j - 1];
+    sorted[j] = v;
+  }
+  if (this->type_ == FILTER_MEDIAN)
+    return n % 2 ? sorted[n / 2] : (uint32_t(sorted[n / 2 - 1]) + sorted[n / 2] + 1) / 2;
+  const uint8_t trim = std::min<uint8_t>(this->trim_, (n - 1) / 2);
+  uint32_t sum = 0;
+  for (uint8_t i = trim; i < n - trim; i++)
+    sum += sorted[i];
+  const uint8_t kept = n - 2 * trim;
+  return (sum + kept / 2) / kept;
+}
+
+}  // namespace m5stack420ma
+}  // namespace esphome
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+namespace m5stack420ma {
+
+enum FilterType : uint8_t {
+  FILTER_MEAN = 0,
+  FILTER_MEDIAN,
+  FILTER_TRIMMED_MEAN,
+};
+
+// Oversampled raw register values of one channel: a fixed ring of the last window_size
+// samples, reduced to one value per publish (mean, median or trimmed mean), then
+// smoothed across publishes by an optional EMA. Integer and fixed-point arithmetic only.
+class SampleFilter {
+ public:
+  static constexpr uint8_t MAX_WINDOW = 32;
+
+  void configure(FilterType type, uint8_t window_size, uint8_t trim, uint16_t ema_alpha_q15);
+  void push(uint16_t sample);
+  // Decimated value from the samples since the last call; false if there were none
+  bool take(uint16_t *value);
+
+ protected:
+  uint16_t reduce_() const;
+
+  FilterType type_{FILTER_MEAN};
+  uint8_t window_size_{1};
+  uint8_t trim_{0};            // samples dropped at each end for the trimmed mean
+  uint16_t ema_alpha_{32768};  // Q15; 32768 disables smoothing
+  uint16_t ring_[MAX_WINDOW]{};
+  uint8_t head_{0};
+  uint8_t count_{0};           // valid samples in the ring, up to window_size
+  bool fresh_{false};          // samples were pushed since the last take()
+  int32_t ema_q8_{0};          // EMA state, raw units * 256
+  bool ema_valid_{false};
+};
+
+}  // namespace m5stack420ma
+}  // namespace esphome
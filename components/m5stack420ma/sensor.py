@@ -1,16 +1,63 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.components import i2c, sensor
-from esphome.const import CONF_ID, ICON_EMPTY, UNIT_EMPTY, CONF_UNIT_OF_MEASUREMENT, CONF_ICON, CONF_ACCURACY_DECIMALS, CONF_UPDATE_INTERVAL, STATE_CLASS_MEASUREMENT
+from esphome import automation
+import esphome.final_validate as fv
+from esphome.components import binary_sensor, i2c, sensor
+from esphome.components.fieldbus import (
+    HISTORY_SCHEMA, STATS_SENSOR_SCHEMA, TRACE_SCHEMA, register_history, register_stats_sensors, register_trace
+)
+from esphome.core import CORE
+from esphome.const import CONF_ADDRESS, CONF_ID, CONF_PLATFORM, ICON_EMPTY, UNIT_EMPTY, CONF_UNIT_OF_MEASUREMENT, CONF_ICON, CONF_ACCURACY_DECIMALS, CONF_UPDATE_INTERVAL, STATE_CLASS_MEASUREMENT
 
 DEPENDENCIES = ['i2c']
+AUTO_LOAD = ['binary_sensor', 'fieldbus']
 
 CONF_CURRENT_VALUE = "current_value"
 CONF_RAW_ADC = "raw_adc"
+CHANNEL_COUNT = 4
+CONF_CHANNELS = [f"channel_{ch}" for ch in range(CHANNEL_COUNT)]
+CONF_OVERSAMPLING = "oversampling"
+CONF_SAMPLE_INTERVAL = "sample_interval"
+CONF_FILTER = "filter"
+CONF_WINDOW_SIZE = "window_size"
+CONF_TRIM = "trim"
+CONF_EMA_ALPHA = "ema_alpha"
+CONF_THRESHOLDS = "thresholds"
+CONF_ABOVE = "above"
+CONF_BELOW = "below"
+CONF_HYSTERESIS = "hysteresis"
+CONF_BINARY_SENSOR = "binary_sensor"
+CONF_ON_ALARM = "on_alarm"
+CONF_ON_CLEAR = "on_clear"
+CONF_TRIGGER_ID = "trigger_id"
+CONF_LOOP_BUDGET = "loop_budget"
+CONF_LOOP_TIME = "loop_time"
+CONF_PROVISION_FROM = "provision_from"
+CONF_I2C_ID = "i2c_id"
+CONF_VALUE = "value"
+CONF_SOURCE = "source"
+CONF_CALIBRATION = "calibration"
+CONF_DEVICE_CALIBRATION = "device_calibration"
+CONF_CHANNEL = "channel"
+CONF_POINT = "point"
+CONF_MAX_RETRIES = "max_retries"
+CONF_OFFLINE_AFTER = "offline_after"
+CONF_POLLER_ID = "poller_id"
+MAX_CALIBRATION_POINTS = 8
 
 
 m5stack420ma_ns = cg.esphome_ns.namespace('m5stack420ma')
 M5Stack420MASensor = m5stack420ma_ns.class_('M5Stack420MASensor', cg.PollingComponent, i2c.I2CDevice)
+FilterType = m5stack420ma_ns.enum('FilterType')
+ThresholdAlarm = m5stack420ma_ns.class_('ThresholdAlarm')
+ModulePoller = m5stack420ma_ns.class_('ModulePoller', cg.Component)
+SetCalibrationPointAction = m5stack420ma_ns.class_('SetCalibrationPointAction', automation.Action)
+DumpTraceAction = m5stack420ma_ns.class_('DumpTraceAction', automation.Action)
+FILTER_TYPES = {
+    "mean": FilterType.FILTER_MEAN,
+    "median": FilterType.FILTER_MEDIAN,
+    "trimmed_mean": FilterType.FILTER_TRIMMED_MEAN,
+}
 
 
 current_schema = sensor.sensor_schema(
@@ -27,27 +74,265 @@ raw_adc_schema = sensor.sensor_schema(
     state_class=STATE_CLASS_MEASUREMENT
 )
 
+# Level alarms in mA, checked on every raw sample (every sample_interval with oversampling)
+threshold_schema = cv.All(
+    cv.Schema(
+        {
+        cv.GenerateID(): cv.declare_id(ThresholdAlarm),
+        cv.Optional(CONF_ABOVE): cv.float_range(min=0.0, max=655.0),
+        cv.Optional(CONF_BELOW): cv.float_range(min=0.0, max=655.0),
+        cv.Optional(CONF_HYSTERESIS, default=0.1): cv.float_range(min=0.0, max=100.0),
+        cv.Optional(CONF_BINARY_SENSOR): binary_sensor.binary_sensor_schema(),
+        cv.Optional(CONF_ON_ALARM): automation.validate_automation(
+            {cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(automation.Trigger.template())}
+        ),
+        cv.Optional(CONF_ON_CLEAR): automation.validate_automation(
+            {cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(automation.Trigger.template())}
+        ),
+        }
+    ),
+    cv.has_exactly_one_key(CONF_ABOVE, CONF_BELOW),
+)
+
+def calibration_point(value):
+    # "4.0 -> 0.0": current in mA (or ADC counts) -> engineering value
+    value = cv.string_strict(value)
+    parts = value.split("->")
+    if len(parts) != 2:
+        raise cv.Invalid("Calibration point must be of the form 'raw -> value'")
+    return cv.float_(parts[0].strip()), cv.float_(parts[1].strip())
+
+
+# Engineering value converted on the device from the filtered current (or the ADC value)
+# through a piecewise linear curve; the points can be re-taught with
+# m5stack420ma.set_calibration_point and are then kept in flash
+value_schema = sensor.sensor_schema(
+    accuracy_decimals=2,
+    state_class=STATE_CLASS_MEASUREMENT
+).extend(
+    {
+    cv.Optional(CONF_SOURCE, default="current"): cv.one_of("current", "adc", lower=True),
+    cv.Required(CONF_CALIBRATION): cv.All(
+        cv.ensure_list(calibration_point), cv.Length(min=2, max=MAX_CALIBRATION_POINTS)
+    ),
+    }
+)
+
+channel_schema = cv.Schema(
+    {
+    cv.Optional(CONF_CURRENT_VALUE): current_schema,
+    cv.Optional(CONF_RAW_ADC): raw_adc_schema,
+    cv.Optional(CONF_THRESHOLDS): cv.ensure_list(threshold_schema),
+    cv.Optional(CONF_VALUE): value_schema,
+    # Reference current flowing when the module is first set up; written to the module's
+    # calibration register once, it keeps the calibration across power cycles
+    cv.Optional(CONF_DEVICE_CALIBRATION): cv.float_range(min=0.01, max=25.0),
+    }
+)
+
+# Read the current registers every sample_interval; each update publishes the filter
+# output over the last window_size samples, smoothed across updates by ema_alpha (1 = off)
+oversampling_schema = cv.Schema(
+    {
+    cv.Required(CONF_SAMPLE_INTERVAL): cv.positive_time_period_milliseconds,
+    cv.Optional(CONF_FILTER, default="median"): cv.enum(FILTER_TYPES, lower=True),
+    cv.Optional(CONF_WINDOW_SIZE, default=16): cv.int_range(min=1, max=32),
+    cv.Optional(CONF_TRIM, default=2): cv.int_range(min=0, max=15),
+    cv.Optional(CONF_EMA_ALPHA, default=1.0): cv.float_range(min=0.01, max=1.0),
+    }
+)
+
+
+CHANNEL_0_KEYS = (CONF_CURRENT_VALUE, CONF_RAW_ADC, CONF_THRESHOLDS, CONF_VALUE, CONF_DEVICE_CALIBRATION)
+
+
+def validate_channel_0(config):
+    # Top-level channel keys are channel 0; do not configure it twice
+    for key in CHANNEL_0_KEYS:
+        if key in config and key in config.get(CONF_CHANNELS[0], {}):
+            raise cv.Invalid(f"{key} is set both at the top level and in {CONF_CHANNELS[0]}")
+    return config
 
-CONFIG_SCHEMA = (
+
+CONFIG_SCHEMA = cv.All(
     cv.Schema(
         {
         cv.GenerateID(): cv.declare_id(M5Stack420MASensor),
+        # Every module declares one; the first module on a bus creates the poller under its
+        # ID and the other modules on that bus share it
+        cv.GenerateID(CONF_POLLER_ID): cv.declare_id(ModulePoller),
         cv.Optional(CONF_UPDATE_INTERVAL): cv.update_interval,
+        # Channel 0, kept for existing configs
         cv.Optional(CONF_CURRENT_VALUE): current_schema,
         cv.Optional(CONF_RAW_ADC): raw_adc_schema,
+        cv.Optional(CONF_THRESHOLDS): cv.ensure_list(threshold_schema),
+        cv.Optional(CONF_VALUE): value_schema,
+        cv.Optional(CONF_DEVICE_CALIBRATION): cv.float_range(min=0.01, max=25.0),
+        **{cv.Optional(name): channel_schema for name in CONF_CHANNELS},
+        cv.Optional(CONF_OVERSAMPLING): oversampling_schema,
+        # loop() does at most one I2C transaction per iteration; publishing is deferred to a
+        # later iteration once this much time was spent
+        cv.Optional(CONF_LOOP_BUDGET, default="2ms"): cv.positive_time_period_microseconds,
+        # Longest loop() iteration of this component per update_interval
+        cv.Optional(CONF_LOOP_TIME): sensor.sensor_schema(
+            unit_of_measurement="µs",
+            icon="mdi:timer-outline",
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_MEASUREMENT
+        ),
+        # A module not answering at its address on first boot is looked for here (the factory
+        # default is 0x55) and moved to the configured address. Add new modules one at a time.
+        cv.Optional(CONF_PROVISION_FROM): cv.i2c_address,
+        # A failed read is retried within the same update after 2ms, 4ms, ...; after
+        # offline_after failed reads in a row the module is only probed, with backoff,
+        # and its sensors report unavailable
+        cv.Optional(CONF_MAX_RETRIES, default=2): cv.int_range(min=0, max=5),
+        cv.Optional(CONF_OFFLINE_AFTER, default=5): cv.int_range(min=1, max=255),
+        # I2C read latency, NACKs/timeouts and update-to-publish time of this module
+        **STATS_SENSOR_SCHEMA,
+        # Record register reads as binary events instead of a debug line each
+        **TRACE_SCHEMA,
+        # Backfill the current, raw ADC and value sensors after an API outage
+        **HISTORY_SCHEMA,
         }
     )
-    .extend(i2c.i2c_device_schema(0x55))  # Assuming 0x55 is the default I2C address
+    .extend(i2c.i2c_device_schema(0x55)),  # Assuming 0x55 is the default I2C address
+    validate_channel_0,
     )
 
-def to_code(config):
+def _final_validate(config):
+    # Provisioning moves whatever answers at provision_from; that must not be a module
+    # this configuration already uses on the same bus
+    if CONF_PROVISION_FROM not in config:
+        return config
+    for other in fv.full_config.get().get("sensor", []):
+        if (
+            other.get(CONF_PLATFORM) == "m5stack420ma"
+            and other[CONF_ID] != config[CONF_ID]
+            and other[CONF_I2C_ID] == config[CONF_I2C_ID]
+            and other[CONF_ADDRESS] == config[CONF_PROVISION_FROM]
+        ):
+            raise cv.Invalid(
+                f"provision_from 0x{config[CONF_PROVISION_FROM]:02X} is the address of '{other[CONF_ID]}'; "
+                "provisioning would move that module",
+                path=[CONF_PROVISION_FROM],
+            )
+    return config
+
+
+FINAL_VALIDATE_SCHEMA = _final_validate
+
+
+async def _module_poller(config):
+    # One poller per I2C bus round-robins the bus work of every module on it
+    pollers = CORE.data.setdefault("m5stack420ma", {}).setdefault("pollers", {})
+    bus_id = config[CONF_I2C_ID]
+    if bus_id.id not in pollers:
+        poller = cg.new_Pvariable(config[CONF_POLLER_ID])
+        await cg.register_component(poller, {})
+        pollers[bus_id.id] = poller
+    return pollers[bus_id.id]
+
+
+async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
-    yield cg.register_component(var, config)
-    yield i2c.register_i2c_device(var, config)
-
-    if CONF_CURRENT_VALUE in config:
-        sensor_ = yield sensor.new_sensor(config[CONF_CURRENT_VALUE])
-        cg.add(var.set_current_sensor(sensor_))
-    if CONF_RAW_ADC in config:
-        sensor_ = yield sensor.new_sensor(config[CONF_RAW_ADC])
-        cg.add(var.set_raw_adc_sensor(sensor_))
\ No newline at end of file
+    await cg.register_component(var, config)
+    await i2c.register_i2c_device(var, config)
+    cg.add(var.set_poller(await _module_poller(config)))
+    if CONF_PROVISION_FROM in config:
+        cg.add(var.set_provision_from(config[CONF_PROVISION_FROM]))
+    await register_stats_sensors(var.get_fieldbus_stats(), config)
+    await register_trace(var.get_trace(), config)
+    cg.add(var.set_loop_budget(config[CONF_LOOP_BUDGET]))
+    cg.add(var.set_max_retries(config[CONF_MAX_RETRIES]))
+    cg.add(var.set_offline_after(config[CONF_OFFLINE_AFTER]))
+    if CONF_LOOP_TIME in config:
+        sensor_ = await sensor.new_sensor(config[CONF_LOOP_TIME])
+        cg.add(var.set_loop_time_sensor(sensor_))
+
+    if CONF_OVERSAMPLING in config:
+        oversampling = config[CONF_OVERSAMPLING]
+        cg.add(var.set_sample_interval(oversampling[CONF_SAMPLE_INTERVAL]))
+        cg.add(var.set_filter(
+            oversampling[CONF_FILTER], oversampling[CONF_WINDOW_SIZE], oversampling[CONF_TRIM],
+            oversampling[CONF_EMA_ALPHA]))
+
+    channels = [config.get(name, {}) for name in CONF_CHANNELS]
+    channels[0] = {
+        **channels[0],
+        **{k: config[k] for k in CHANNEL_0_KEYS if k in config},
+    }
+    history = []
+    for ch, channel in enumerate(channels):
+        if CONF_CURRENT_VALUE in channel:
+            sensor_ = await sensor.new_sensor(channel[CONF_CURRENT_VALUE])
+            cg.add(var.set_current_sensor(ch, sensor_))
+            history.append(sensor_)
+        if CONF_RAW_ADC in channel:
+            sensor_ = await sensor.new_sensor(channel[CONF_RAW_ADC])
+            cg.add(var.set_raw_adc_sensor(ch, sensor_))
+            history.append(sensor_)
+        if CONF_VALUE in channel:
+            value = channel[CONF_VALUE]
+            sensor_ = await sensor.new_sensor(value)
+            history.append(sensor_)
+            from_adc = value[CONF_SOURCE] == "adc"
+            cg.add(var.set_value_sensor(ch, sensor_, from_adc))
+            for raw, eng in sorted(value[CONF_CALIBRATION]):
+                cg.add(var.add_calibration_point(ch, round(raw if from_adc else raw * 100), eng))
+        if CONF_DEVICE_CALIBRATION in channel:
+            cg.add(var.set_device_calibration(ch, round(channel[CONF_DEVICE_CALIBRATION] * 100)))
+        for threshold in channel.get(CONF_THRESHOLDS, []):
+            above = CONF_ABOVE in threshold
+            level = threshold[CONF_ABOVE] if above else threshold[CONF_BELOW]
+            alarm = cg.new_Pvariable(
+                threshold[CONF_ID], ch, above, round(level * 100), round(threshold[CONF_HYSTERESIS] * 100))
+            if CONF_BINARY_SENSOR in threshold:
+                bin_sens = await binary_sensor.new_binary_sensor(threshold[CONF_BINARY_SENSOR])
+                cg.add(alarm.set_binary_sensor(bin_sens))
+            for conf in threshold.get(CONF_ON_ALARM, []):
+                trigger = cg.Pvariable(conf[CONF_TRIGGER_ID], alarm.get_alarm_trigger())
+                await automation.build_automation(trigger, [], conf)
+            for conf in threshold.get(CONF_ON_CLEAR, []):
+                trigger = cg.Pvariable(conf[CONF_TRIGGER_ID], alarm.get_clear_trigger())
+                await automation.build_automation(trigger, [], conf)
+            cg.add(var.add_alarm(alarm))
+    await register_history(history, config)
+
+
+# Teach point `point` (in ascending raw order) of the channel's curve: the raw value the
+# channel reads now maps to `value`
+@automation.register_action(
+    "m5stack420ma.set_calibration_point",
+    SetCalibrationPointAction,
+    cv.Schema(
+        {
+        cv.GenerateID(): cv.use_id(M5Stack420MASensor),
+        cv.Required(CONF_CHANNEL): cv.templatable(cv.int_range(min=0, max=CHANNEL_COUNT - 1)),
+        cv.Required(CONF_POINT): cv.templatable(cv.int_range(min=0, max=MAX_CALIBRATION_POINTS - 1)),
+        cv.Required(CONF_VALUE): cv.templatable(cv.float_),
+        }
+    ),
+)
+async def set_calibration_point_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    template_ = await cg.templatable(config[CONF_CHANNEL], args, cg.uint8)
+    cg.add(var.set_channel(template_))
+    template_ = await cg.templatable(config[CONF_POINT], args, cg.uint8)
+    cg.add(var.set_point(template_))
+    template_ = await cg.templatable(config[CONF_VALUE], args, cg.float_)
+    cg.add(var.set_value(template_))
+    return var
+
+
+# Log the buffered trace events now, e.g. from an API service
+@automation.register_action(
+    "m5stack420ma.dump_trace",
+    DumpTraceAction,
+    cv.Schema({cv.GenerateID(): cv.use_id(M5Stack420MASensor)}),
+)
+async def dump_trace_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
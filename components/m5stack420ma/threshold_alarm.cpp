@@ -0,0 +1,41 @@
+#include "threshold_alarm.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace m5stack420ma {
+
+static const char *const TAG = "m5stack420ma.alarm";
+
+void ThresholdAlarm::evaluate(uint16_t raw) {
+  bool active;
+  if (this->above_) {
+    active = this->active_ ? raw + this->hysteresis_ > this->level_ : raw > this->level_;
+  } else {
+    active = this->active_ ? raw < this->level_ + this->hysteresis_ : raw < this->level_;
+  }
+  if (this->known_ && active == this->active_)
+    return;
+  const bool first = !this->known_;
+  this->known_ = true;
+  this->active_ = active;
+  if (this->binary_sensor_ != nullptr)
+    this->binary_sensor_->publish_state(active);
+  if (first && !active)
+    return;  // starting out clear is not a crossing
+  ESP_LOGD(TAG, "Channel %u %s %.2f mA: %s (%.2f mA)", this->channel_, this->above_ ? "above" : "below",
+           this->level_ / 100.0f, active ? "alarm" : "clear", raw / 100.0f);
+  if (active) {
+    this->alarm_trigger_.trigger();
+  } else {
+    this->clear_trigger_.trigger();
+  }
+}
+
+void ThresholdAlarm::dump_config(const char *tag) {
+  ESP_LOGCONFIG(tag, "  Channel %u alarm %s %.2f mA (hysteresis %.2f mA)", this->channel_,
+                this->above_ ? "above" : "below", this->level_ / 100.0f, this->hysteresis_ / 100.0f);
+  LOG_BINARY_SENSOR("    ", "Binary Sensor", this->binary_sensor_);
+}
+
+}  // namespace m5stack420ma
+}  // namespace esphome
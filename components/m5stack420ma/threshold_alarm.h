@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esphome/core/automation.h"
+#include "esphome/components/binary_sensor/binary_sensor.h"
+
+namespace esphome {
+namespace m5stack420ma {
+
+// Level alarm on one channel, evaluated on every raw sample rather than at publish time.
+// An `above` alarm sets when the current exceeds the level and clears once it falls below
+// level - hysteresis; a `below` alarm mirrors that. Levels are in raw units (0.01 mA).
+class ThresholdAlarm {
+ public:
+  ThresholdAlarm(uint8_t channel, bool above, uint16_t level, uint16_t hysteresis)
+      : channel_(channel), above_(above), level_(level), hysteresis_(hysteresis) {}
+
+  void set_binary_sensor(binary_sensor::BinarySensor *binary_sensor) { this->binary_sensor_ = binary_sensor; }
+  Trigger<> *get_alarm_trigger() { return &this->alarm_trigger_; }
+  Trigger<> *get_clear_trigger() { return &this->clear_trigger_; }
+  uint8_t get_channel() const { return this->channel_; }
+
+  void evaluate(uint16_t raw);
+  void dump_config(const char *tag);
+
+ protected:
+  uint8_t channel_;
+  bool above_;
+  uint16_t level_;
+  uint16_t hysteresis_;
+  bool active_{false};
+  bool known_{false};
+  binary_sensor::BinarySensor *binary_sensor_{nullptr};
+  Trigger<> alarm_trigger_;
+  Trigger<> clear_trigger_;
+};
+
+}  // namespace m5stack420ma
+}  // namespace esphome
@@ -3,6 +3,7 @@ from esphome.components import climate
 
 save_vtr_ns = cg.esphome_ns.namespace("save_vtr")
 SaveVTRClimate = save_vtr_ns.class_("SaveVTRClimate", climate.Climate, cg.PollingComponent)
+RegisterId = save_vtr_ns.enum("RegisterId")
 
 CODEOWNERS = ["@atleso"]
 
@@ -15,6 +16,6 @@ CONFIG_SCHEMA = cv.Schema({})
 async def to_code(config):
     pass
 
-AUTO_LOAD = ["climate", "sensor"]
+AUTO_LOAD = ["climate", "sensor", "binary_sensor", "fieldbus"]
 
 
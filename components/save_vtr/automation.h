@@ -0,0 +1,16 @@
+#pragma once
+
+#include "esphome/core/automation.h"
+#include "save_vtr.h"
+
+namespace esphome {
+namespace save_vtr {
+
+// Log every trace event not logged yet
+template<typename... Ts> class DumpTraceAction : public Action<Ts...>, public Parented<SaveVTRClimate> {
+ public:
+  void play(Ts... x) override { this->parent_->dump_trace(); }
+};
+
+}  // namespace save_vtr
+}  // namespace esphome
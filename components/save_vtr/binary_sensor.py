@@ -0,0 +1,35 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import binary_sensor
+from esphome.const import CONF_ADDRESS, CONF_ID
+from . import save_vtr_ns, SaveVTRClimate
+
+DEPENDENCIES = ["save_vtr"]
+
+CONF_SAVE_VTR_ID = "save_vtr_id"
+CONF_REGISTER_TYPE = "register_type"
+CONF_BITMASK = "bitmask"
+
+SaveVTRBinarySensor = save_vtr_ns.class_("SaveVTRBinarySensor", binary_sensor.BinarySensor)
+
+ModbusRegisterType = cg.esphome_ns.namespace("modbus_controller").enum("ModbusRegisterType", is_class=True)
+REGISTER_TYPES = {
+    "holding": ModbusRegisterType.HOLDING,
+    "read": ModbusRegisterType.READ,
+}
+
+# Served from the climate's register cache: the register is polled together with the
+# climate registers and never read twice within cache_ttl
+CONFIG_SCHEMA = binary_sensor.binary_sensor_schema(SaveVTRBinarySensor).extend({
+    cv.GenerateID(CONF_SAVE_VTR_ID): cv.use_id(SaveVTRClimate),
+    cv.Required(CONF_ADDRESS): cv.uint16_t,
+    cv.Optional(CONF_REGISTER_TYPE, default="read"): cv.enum(REGISTER_TYPES),
+    cv.Optional(CONF_BITMASK, default=0xFFFF): cv.hex_uint16_t,
+})
+
+async def to_code(config):
+    paren = await cg.get_variable(config[CONF_SAVE_VTR_ID])
+    var = await binary_sensor.new_binary_sensor(config)
+    cg.add(var.set_register(config[CONF_REGISTER_TYPE], config[CONF_ADDRESS]))
+    cg.add(var.set_bitmask(config[CONF_BITMASK]))
+    cg.add(paren.register_binary_sensor(var))
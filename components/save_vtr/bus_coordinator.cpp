@@ -0,0 +1,106 @@
+#include "bus_coordinator.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+#include <algorithm>
+#include <cinttypes>
+
+namespace esphome {
+namespace save_vtr {
+
+static const char *const TAG = "save_vtr.bus";
+
+uint8_t BusCoordinator::add_unit(uint8_t budget) {
+  this->budgets_.push_back(budget);
+  return this->budgets_.size() - 1;
+}
+
+bool BusCoordinator::try_acquire(uint8_t unit, bool urgent, uint32_t now) {
+  const uint32_t bit = 1UL << unit;
+  this->wanting_ |= bit;
+  if (urgent) {
+    this->urgent_ |= bit;
+  } else {
+    this->urgent_ &= ~bit;
+  }
+  if (this->holder_ != NO_UNIT)
+    return false;
+
+  // The unit whose turn it is keeps the bus until its budget is used up; otherwise the
+  // next unit after it in round-robin order goes, looking at urgent units first
+  const uint32_t candidates = this->urgent_ != 0 ? this->urgent_ : this->wanting_;
+  uint8_t next = NO_UNIT;
+  if (this->last_ != NO_UNIT && (candidates & (1UL << this->last_)) && this->turn_used_ < this->budgets_[this->last_]) {
+    next = this->last_;
+  } else {
+    const uint8_t count = this->budgets_.size();
+    const uint8_t start = this->last_ == NO_UNIT ? 0 : this->last_ + 1;
+    for (uint8_t i = 0; i < count; i++) {
+      const uint8_t candidate = (start + i) % count;
+      if (candidates & (1UL << candidate)) {
+        next = candidate;
+        break;
+      }
+    }
+  }
+  if (next != unit)
+    return false;
+
+  this->wanting_ &= ~bit;
+  this->urgent_ &= ~bit;
+  this->turn_used_ = unit == this->last_ ? this->turn_used_ + 1 : 1;
+  this->last_ = unit;
+  this->holder_ = unit;
+  this->busy_since_ = now;
+  this->transactions_++;
+  return true;
+}
+
+void BusCoordinator::release(uint8_t unit, uint32_t now) {
+  if (this->holder_ != unit)
+    return;
+  this->busy_total_ += now - this->busy_since_;
+  this->holder_ = NO_UNIT;
+}
+
+void BusCoordinator::idle(uint8_t unit) {
+  this->wanting_ &= ~(1UL << unit);
+  this->urgent_ &= ~(1UL << unit);
+}
+
+uint32_t BusCoordinator::phase_delay(uint8_t unit, uint32_t interval, uint32_t now) const {
+  if (this->budgets_.size() < 2 || interval == 0)
+    return 0;
+  const uint32_t phase = interval / this->budgets_.size() * unit;
+  return (phase + interval - now % interval) % interval;
+}
+
+void BusCoordinator::update() {
+  const uint32_t now = millis();
+  uint32_t busy = this->busy_total_;
+  if (this->holder_ != NO_UNIT) {
+    // Count the command in progress up to now and the rest in the next window
+    busy += now - this->busy_since_;
+    this->busy_since_ = now;
+  }
+  const uint32_t elapsed = now - this->window_start_;
+  if (elapsed > 0)
+    this->utilization_ = std::min(100.0f, 100.0f * busy / elapsed);
+  ESP_LOGV(TAG, "Bus utilization %.1f%% (%" PRIu32 " commands)", this->utilization_, this->transactions_);
+  if (this->utilization_sensor_ != nullptr)
+    this->utilization_sensor_->publish_state(this->utilization_);
+  this->busy_total_ = 0;
+  this->transactions_ = 0;
+  this->window_start_ = now;
+}
+
+void BusCoordinator::dump_config() {
+  ESP_LOGCONFIG(TAG, "SAVE VTR bus coordinator:");
+  ESP_LOGCONFIG(TAG, "  Units: %zu", this->budgets_.size());
+  for (size_t i = 0; i < this->budgets_.size(); i++)
+    ESP_LOGCONFIG(TAG, "    Unit %zu: up to %u commands per turn", i, this->budgets_[i]);
+  ESP_LOGCONFIG(TAG, "  Utilization: %.1f%%", this->utilization_);
+  LOG_SENSOR("  ", "Utilization", this->utilization_sensor_);
+}
+
+}  // namespace save_vtr
+}  // namespace esphome
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "esphome/core/component.h"
+#include "esphome/components/sensor/sensor.h"
+
+namespace esphome {
+namespace save_vtr {
+
+// Shares one RS-485 segment between every save_vtr unit on the same modbus. Only one
+// unit has a command on the bus at a time; the bus is granted round-robin, writes and
+// read-backs of any unit ahead of regular reads, and a unit may send up to its budget of
+// commands per turn. Poll phases are spread evenly across the units.
+class BusCoordinator : public PollingComponent {
+ public:
+  static constexpr uint8_t MAX_UNITS = 32;
+  static constexpr uint8_t NO_UNIT = 0xFF;
+
+  BusCoordinator() : PollingComponent(60000) {}
+
+  void update() override;
+  void dump_config() override;
+  float get_setup_priority() const override { return setup_priority::DATA; }
+
+  // Called from codegen for each unit; returns the unit's index
+  uint8_t add_unit(uint8_t budget);
+  void set_utilization_sensor(sensor::Sensor *sensor) { this->utilization_sensor_ = sensor; }
+
+  // A unit with work asks for the bus; true means it may send one command now
+  bool try_acquire(uint8_t unit, bool urgent, uint32_t now);
+  // The unit's command answered or timed out
+  void release(uint8_t unit, uint32_t now);
+  // The unit has nothing to send
+  void idle(uint8_t unit);
+  // Delay before a unit's update_interval poll so units on the bus do not poll in phase
+  uint32_t phase_delay(uint8_t unit, uint32_t interval, uint32_t now) const;
+
+ protected:
+  std::vector<uint8_t> budgets_;
+  uint32_t wanting_{0};  // unit bitmasks
+  uint32_t urgent_{0};
+  uint8_t holder_{NO_UNIT};
+  uint8_t last_{NO_UNIT};  // unit whose turn it is or was
+  uint8_t turn_used_{0};
+
+  // Utilization: time a command of any unit was on the bus, per update_interval
+  uint32_t busy_since_{0};
+  uint32_t busy_total_{0};
+  uint32_t window_start_{0};
+  uint32_t transactions_{0};
+  float utilization_{0.0f};
+  sensor::Sensor *utilization_sensor_{nullptr};
+};
+
+}  // namespace save_vtr
+}  // namespace esphome
@@ -1,27 +1,175 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.components import climate
+from esphome import automation
+from esphome.components import binary_sensor, climate
+from esphome.components.fieldbus import TRACE_SCHEMA, register_trace
 from esphome.components.modbus_controller import ModbusController
-from esphome.const import CONF_ID, CONF_UPDATE_INTERVAL
+from esphome.const import (
+    CONF_ID,
+    CONF_UPDATE_INTERVAL,
+    DEVICE_CLASS_PROBLEM,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+)
+from esphome.core import CORE
 
 DEPENDENCIES = ["modbus_controller"]
 
 save_vtr_ns = cg.esphome_ns.namespace("save_vtr")
 SaveVTRClimate = save_vtr_ns.class_("SaveVTRClimate", climate.Climate, cg.PollingComponent)
+RegisterId = save_vtr_ns.enum("RegisterId")
+BusCoordinator = save_vtr_ns.class_("BusCoordinator", cg.PollingComponent)
+DumpTraceAction = save_vtr_ns.class_("DumpTraceAction", automation.Action)
 
+CONF_MAX_READ_GAP = "max_read_gap"
+CONF_MAX_REGISTERS_PER_READ = "max_registers_per_read"
+CONF_POLL_TIMEOUT = "poll_timeout"
+CONF_SETPOINT_POLL_INTERVAL = "setpoint_poll_interval"
+CONF_CURRENT_TEMPERATURE_POLL_INTERVAL = "current_temperature_poll_interval"
+CONF_FAN_MODE_POLL_INTERVAL = "fan_mode_poll_interval"
+CONF_FAN_BOOST_INTERVAL = "fan_boost_interval"
+CONF_FAN_BOOST_DURATION = "fan_boost_duration"
+CONF_COMMAND_TIMEOUT = "command_timeout"
+CONF_WRITE_DEBOUNCE = "write_debounce"
+CONF_WRITE_MULTIPLE = "write_multiple"
+CONF_OFFLINE_AFTER = "offline_after"
+CONF_PROBE_INTERVAL = "probe_interval"
+CONF_MAX_PROBE_INTERVAL = "max_probe_interval"
+CONF_CACHE_TTL = "cache_ttl"
+CONF_SNAPSHOT_INTERVAL = "snapshot_interval"
+CONF_BUS_BUDGET = "bus_budget"
+CONF_STALE = "stale"
+CONF_BUS_COORDINATOR_ID = "bus_coordinator_id"
 
+# Registers owned by the climate entity itself, polled at update_interval unless overridden
+CLIMATE_POLL_INTERVALS = {
+    CONF_SETPOINT_POLL_INTERVAL: RegisterId.REGISTER_SETPOINT,
+    CONF_CURRENT_TEMPERATURE_POLL_INTERVAL: RegisterId.REGISTER_SUPPLY_TEMP,
+    CONF_FAN_MODE_POLL_INTERVAL: RegisterId.REGISTER_FAN_MODE,
+}
 
-CONFIG_SCHEMA = climate.climate_schema(SaveVTRClimate).extend(
-    {
-        cv.Required("modbus_id"): cv.use_id(ModbusController),
-        cv.Optional(CONF_UPDATE_INTERVAL, default="30s"): cv.update_interval,
-    }
+# cv.positive_not_null_time_period in milliseconds: a 0s timeout expires at once, a 0s probe
+# interval probes an offline unit on every loop()
+positive_not_null_time_period_milliseconds = cv.All(
+    cv.positive_time_period_milliseconds, cv.Range(min=cv.TimePeriod(), min_included=False)
 )
 
 
+def validate_probe_intervals(config):
+    # The backoff doubles from probe_interval and is capped at max_probe_interval
+    if config[CONF_MAX_PROBE_INTERVAL] < config[CONF_PROBE_INTERVAL]:
+        raise cv.Invalid(f"{CONF_MAX_PROBE_INTERVAL} must not be shorter than {CONF_PROBE_INTERVAL}")
+    return config
+
+
+CONFIG_SCHEMA = cv.All(
+    climate.climate_schema(SaveVTRClimate).extend(
+        {
+            cv.Required("modbus_id"): cv.use_id(ModbusController),
+            # Every unit declares one; the first unit on a bus creates the coordinator under
+            # its ID and the other units on that bus share it
+            cv.GenerateID(CONF_BUS_COORDINATOR_ID): cv.declare_id(BusCoordinator),
+            cv.Optional(CONF_UPDATE_INTERVAL, default="30s"): cv.update_interval,
+            # Registers at most this many addresses apart are fetched in one read
+            cv.Optional(CONF_MAX_READ_GAP, default=0): cv.int_range(min=0, max=32),
+            cv.Optional(CONF_MAX_REGISTERS_PER_READ, default=16): cv.int_range(min=1, max=125),
+            # Publish a poll cycle once all reads answered, or at the latest after this long
+            cv.Optional(CONF_POLL_TIMEOUT, default="10s"): positive_not_null_time_period_milliseconds,
+            **{
+                cv.Optional(name): cv.positive_time_period_milliseconds
+                for name in CLIMATE_POLL_INTERVALS
+            },
+            # After a fan mode change, poll airflow, fan RPM and fan mode faster for a while
+            cv.Optional(CONF_FAN_BOOST_INTERVAL, default="5s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_FAN_BOOST_DURATION, default="60s"): cv.positive_time_period_milliseconds,
+            # Commands are handed to the controller one at a time; move on if one is not answered
+            cv.Optional(CONF_COMMAND_TIMEOUT, default="2s"): positive_not_null_time_period_milliseconds,
+            # Collapse bursts of setpoint/fan mode changes into the last value
+            cv.Optional(CONF_WRITE_DEBOUNCE, default="500ms"): cv.positive_time_period_milliseconds,
+            # Send writes to adjacent registers as one Write Multiple Registers frame
+            cv.Optional(CONF_WRITE_MULTIPLE, default=True): cv.boolean,
+            # Stop polling after this many unanswered commands in a row and probe a single register
+            # with exponential backoff until the unit answers again
+            cv.Optional(CONF_OFFLINE_AFTER, default=3): cv.int_range(min=1, max=255),
+            cv.Optional(CONF_PROBE_INTERVAL, default="10s"): positive_not_null_time_period_milliseconds,
+            cv.Optional(CONF_MAX_PROBE_INTERVAL, default="5min"): positive_not_null_time_period_milliseconds,
+            # Registers read this recently are served from the register cache instead of the bus;
+            # keep it below the shortest poll interval
+            cv.Optional(CONF_CACHE_TTL, default="1s"): cv.positive_time_period_milliseconds,
+            # Keep the last read values in flash, written at most this often, and publish them
+            # (as stale) right after boot; 0s disables the snapshot
+            cv.Optional(CONF_SNAPSHOT_INTERVAL, default="15min"): cv.positive_time_period_milliseconds,
+            # Commands this unit may send in a row when several units share the bus
+            cv.Optional(CONF_BUS_BUDGET, default=1): cv.int_range(min=1, max=16),
+            # Record register reads as binary events instead of a debug line each
+            **TRACE_SCHEMA,
+            # On while a published value came from the flash snapshot or its register missed
+            # the poll deadline, until the register is read again
+            cv.Optional(CONF_STALE): binary_sensor.binary_sensor_schema(
+                device_class=DEVICE_CLASS_PROBLEM,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            ),
+        }
+    ),
+    validate_probe_intervals,
+)
+
+
+def _bus_id(controller_id):
+    # The modbus (RS-485 segment) behind a modbus_controller
+    for conf in CORE.config.get("modbus_controller", []):
+        if conf[CONF_ID].id == controller_id.id:
+            return conf["modbus_id"]
+    return controller_id
+
+
+async def _bus_coordinator(config):
+    # One coordinator per bus, shared by every save_vtr unit on it
+    bus_id = _bus_id(config["modbus_id"])
+    coordinators = CORE.data.setdefault("save_vtr", {}).setdefault("bus_coordinators", {})
+    if bus_id.id not in coordinators:
+        coordinator = cg.new_Pvariable(config[CONF_BUS_COORDINATOR_ID])
+        await cg.register_component(coordinator, {})
+        coordinators[bus_id.id] = coordinator
+    return coordinators[bus_id.id]
+
+
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
     await climate.register_climate(var, config)
     modbus = await cg.get_variable(config["modbus_id"])
     cg.add(var.set_modbus(modbus))
+    cg.add(var.set_max_read_gap(config[CONF_MAX_READ_GAP]))
+    cg.add(var.set_max_registers_per_read(config[CONF_MAX_REGISTERS_PER_READ]))
+    cg.add(var.set_poll_timeout(config[CONF_POLL_TIMEOUT]))
+    for name, register in CLIMATE_POLL_INTERVALS.items():
+        if name in config:
+            cg.add(var.set_poll_interval(register, config[name]))
+    cg.add(var.set_fan_boost_interval(config[CONF_FAN_BOOST_INTERVAL]))
+    cg.add(var.set_fan_boost_duration(config[CONF_FAN_BOOST_DURATION]))
+    cg.add(var.set_command_timeout(config[CONF_COMMAND_TIMEOUT]))
+    cg.add(var.set_write_debounce(config[CONF_WRITE_DEBOUNCE]))
+    cg.add(var.set_write_multiple(config[CONF_WRITE_MULTIPLE]))
+    cg.add(var.set_offline_after(config[CONF_OFFLINE_AFTER]))
+    cg.add(var.set_probe_interval(config[CONF_PROBE_INTERVAL]))
+    cg.add(var.set_max_probe_interval(config[CONF_MAX_PROBE_INTERVAL]))
+    cg.add(var.set_cache_ttl(config[CONF_CACHE_TTL]))
+    cg.add(var.set_snapshot_interval(config[CONF_SNAPSHOT_INTERVAL]))
+    await register_trace(var.get_trace(), config)
+    if CONF_STALE in config:
+        sens = await binary_sensor.new_binary_sensor(config[CONF_STALE])
+        cg.add(var.set_stale_sensor(sens))
+    coordinator = await _bus_coordinator(config)
+    cg.add(var.set_bus_coordinator(coordinator, config[CONF_BUS_BUDGET]))
+
+
+# Log the buffered trace events now, e.g. from an API service
+@automation.register_action(
+    "save_vtr.dump_trace",
+    DumpTraceAction,
+    cv.Schema({cv.GenerateID(): cv.use_id(SaveVTRClimate)}),
+)
+async def dump_trace_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esphome/components/modbus_controller/modbus_controller.h"
+
+namespace esphome {
+namespace save_vtr {
+
+// Last value read from one register of the unit
+struct CachedRegister {
+  modbus_controller::ModbusRegisterType register_type;
+  uint16_t address;
+  uint16_t value;
+  uint32_t updated_at;
+  bool used;
+  bool valid;
+};
+
+// Per-unit register cache shared by every save_vtr platform. Slots below REGISTER_COUNT
+// hold the climate's own registers (slot == RegisterId); registers requested by other
+// platforms get the slots above. A register is only fetched from the bus once per TTL,
+// however many entities read it.
+class RegisterCache {
+ public:
+  static constexpr uint8_t MAX_REGISTERS = 32;
+  static constexpr uint8_t NO_SLOT = 0xFF;
+
+  void set_ttl(uint32_t ttl) { this->ttl_ = ttl; }
+  uint32_t get_ttl() const { return this->ttl_; }
+
+  // Bind a fixed slot to its register
+  void assign(uint8_t slot, modbus_controller::ModbusRegisterType register_type, uint16_t address) {
+    this->entries_[slot] = CachedRegister{register_type, address, 0, 0, true, false};
+  }
+
+  // Slot already holding this register, else the first free slot from first_free up (NO_SLOT when full)
+  uint8_t find_or_add(modbus_controller::ModbusRegisterType register_type, uint16_t address, uint8_t first_free) {
+    for (uint8_t i = 0; i < MAX_REGISTERS; i++) {
+      const auto &entry = this->entries_[i];
+      if (entry.used && entry.register_type == register_type && entry.address == address)
+        return i;
+    }
+    for (uint8_t i = first_free; i < MAX_REGISTERS; i++) {
+      if (!this->entries_[i].used) {
+        this->assign(i, register_type, address);
+        return i;
+      }
+    }
+    return NO_SLOT;
+  }
+
+  void store(uint8_t slot, uint16_t value, uint32_t now) {
+    auto &entry = this->entries_[slot];
+    entry.value = value;
+    entry.updated_at = now;
+    entry.valid = true;
+  }
+
+  void invalidate_all() {
+    for (auto &entry : this->entries_)
+      entry.valid = false;
+  }
+
+  bool get(uint8_t slot, uint16_t *value) const {
+    const auto &entry = this->entries_[slot];
+    if (!entry.valid)
+      return false;
+    *value = entry.value;
+    return true;
+  }
+
+  // Read from the bus less than ttl ago
+  bool is_fresh(uint8_t slot, uint32_t now) const {
+    const auto &entry = this->entries_[slot];
+    return entry.valid && now - entry.updated_at < this->ttl_;
+  }
+
+  const CachedRegister &operator[](uint8_t slot) const { return this->entries_[slot]; }
+
+ protected:
+  uint32_t ttl_{1000};
+  CachedRegister entries_[MAX_REGISTERS]{};
+};
+
+}  // namespace save_vtr
+}  // namespace esphome
@@ -0,0 +1,42 @@
+#include "register_plan.h"
+#include <algorithm>
+
+namespace esphome {
+namespace save_vtr {
+
+void RegisterPlanner::add_register(modbus_controller::ModbusRegisterType register_type, uint16_t address,
+                                   uint8_t id) {
+  for (auto &reg : this->registers_) {
+    if (reg.register_type == register_type && reg.address == address)
+      return;  // already planned
+  }
+  this->registers_.push_back(PlannedRegister{register_type, address, id});
+}
+
+void RegisterPlanner::plan() {
+  std::sort(this->registers_.begin(), this->registers_.end(), [](const PlannedRegister &a, const PlannedRegister &b) {
+    if (a.register_type != b.register_type)
+      return a.register_type < b.register_type;
+    return a.address < b.address;
+  });
+
+  this->blocks_.clear();
+  for (size_t i = 0; i < this->registers_.size(); i++) {
+    const auto &reg = this->registers_[i];
+    if (!this->blocks_.empty()) {
+      auto &block = this->blocks_.back();
+      uint32_t block_end = block.start_address + block.register_count;  // one past the last register
+      uint32_t new_count = reg.address - block.start_address + 1;
+      if (block.register_type == reg.register_type && reg.address - block_end <= this->max_gap_ &&
+          new_count <= this->max_count_) {
+        block.register_count = new_count;
+        block.size++;
+        continue;
+      }
+    }
+    this->blocks_.push_back(ReadBlock{reg.register_type, reg.address, 1, static_cast<uint8_t>(i), 1});
+  }
+}
+
+}  // namespace save_vtr
+}  // namespace esphome
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "esphome/components/modbus_controller/modbus_controller.h"
+
+namespace esphome {
+namespace save_vtr {
+
+// A register that should be polled. `id` is opaque to the planner and handed back per block member.
+struct PlannedRegister {
+  modbus_controller::ModbusRegisterType register_type;
+  uint16_t address;
+  uint8_t id;
+};
+
+// One multi-register read covering [start_address, start_address + register_count).
+// Its members are planner.registers()[first .. first + size).
+struct ReadBlock {
+  modbus_controller::ModbusRegisterType register_type;
+  uint16_t start_address;
+  uint16_t register_count;
+  uint8_t first;
+  uint8_t size;
+};
+
+// Groups registers by type and address and coalesces contiguous or near-contiguous
+// registers into as few Modbus reads as possible.
+class RegisterPlanner {
+ public:
+  // Largest number of unused registers allowed between two members of one block
+  void set_max_gap(uint16_t max_gap) { this->max_gap_ = max_gap; }
+  // Largest number of registers covered by a single read (Modbus allows up to 125)
+  void set_max_count(uint16_t max_count) { this->max_count_ = max_count; }
+
+  void add_register(modbus_controller::ModbusRegisterType register_type, uint16_t address, uint8_t id);
+  // Sort the registers and (re)build the read blocks
+  void plan();
+
+  const std::vector<PlannedRegister> &registers() const { return this->registers_; }
+  const std::vector<ReadBlock> &blocks() const { return this->blocks_; }
+
+  // Byte offset of a block member inside the block's response buffer
+  static size_t offset_of(const ReadBlock &block, const PlannedRegister &reg) {
+    return static_cast<size_t>(reg.address - block.start_address) * 2;
+  }
+
+ protected:
+  uint16_t max_gap_{0};
+  uint16_t max_count_{16};
+  std::vector<PlannedRegister> registers_;
+  std::vector<ReadBlock> blocks_;
+};
+
+}  // namespace save_vtr
+}  // namespace esphome
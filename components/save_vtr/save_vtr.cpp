@@ -1,5 +1,9 @@
 #include "save_vtr.h"
 #include "esphome/core/log.h"
+#include "esphome/core/helpers.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
 
 namespace esphome {
 namespace save_vtr {
@@ -18,10 +22,93 @@ static constexpr uint16_t REG_EXTRACT_AIRFLOW = 14001;  // Extract air flow volu
 static constexpr uint16_t REG_SENSOR_RPM_SAF = 12400;   // Supply air fan RPM (input register)
 static constexpr uint16_t REG_SENSOR_RPM_EAF = 12401;   // Extract air fan RPM (input register)
 
+static const char *const TAG = "save_vtr.climate";
+
+// Registers that follow a fan mode change within seconds
+static constexpr uint16_t FAN_REGISTERS = (1 << REGISTER_FAN_MODE) | (1 << REGISTER_SUPPLY_AIRFLOW) |
+                                          (1 << REGISTER_EXTRACT_AIRFLOW) | (1 << REGISTER_RPM_SAF) |
+                                          (1 << REGISTER_RPM_EAF);
+
+using modbus_controller::ModbusRegisterType;
+
+// Every value decoded from a polled register. A register feeding several values (airflow
+// as % and m³/h) appears once per value; the planner reads it only once.
+constexpr RegisterDescriptor SaveVTRClimate::REGISTERS[] = {
+    {REGISTER_SETPOINT, ModbusRegisterType::HOLDING, REG_SETPOINT, true, 0.1f,
+     &SaveVTRClimate::target_temperature, nullptr, "setpoint", "°C"},
+    {REGISTER_OUTDOOR_TEMP, ModbusRegisterType::HOLDING, REG_OUTDOOR_TEMP, true, 0.1f,
+     &SaveVTRClimate::outdoor_air_temp_, &SaveVTRClimate::outdoor_air_temp_sensor_, "outdoor air temperature", "°C"},
+    {REGISTER_SUPPLY_TEMP, ModbusRegisterType::HOLDING, REG_SUPPLY_TEMP, true, 0.1f,
+     &SaveVTRClimate::supply_air_temp_, &SaveVTRClimate::supply_air_temp_sensor_, "supply air temperature", "°C"},
+    {REGISTER_EXTRACT_TEMP, ModbusRegisterType::HOLDING, REG_EXTRACT_TEMP, true, 0.1f,
+     &SaveVTRClimate::extract_air_temp_, &SaveVTRClimate::extract_air_temp_sensor_, "extract air temperature", "°C"},
+    {REGISTER_HEAT_DEMAND, ModbusRegisterType::READ, REG_HEAT_DEMAND, false, 1.0f,
+     &SaveVTRClimate::heat_demand_percent_, &SaveVTRClimate::heat_demand_sensor_, "heat demand", "%"},
+    {REGISTER_SUPPLY_AIRFLOW, ModbusRegisterType::READ, REG_SUPPLY_AIRFLOW, false, 1.0f,
+     &SaveVTRClimate::saf_percent_, &SaveVTRClimate::saf_percent_sensor_, "supply air flow", "%"},
+    {REGISTER_SUPPLY_AIRFLOW, ModbusRegisterType::READ, REG_SUPPLY_AIRFLOW, false, 3.0f,
+     &SaveVTRClimate::saf_volume_, &SaveVTRClimate::saf_volume_sensor_, "supply air flow", " m³/h"},
+    {REGISTER_EXTRACT_AIRFLOW, ModbusRegisterType::READ, REG_EXTRACT_AIRFLOW, false, 1.0f,
+     &SaveVTRClimate::eaf_percent_, &SaveVTRClimate::eaf_percent_sensor_, "extract air flow", "%"},
+    {REGISTER_EXTRACT_AIRFLOW, ModbusRegisterType::READ, REG_EXTRACT_AIRFLOW, false, 3.0f,
+     &SaveVTRClimate::eaf_volume_, &SaveVTRClimate::eaf_volume_sensor_, "extract air flow", " m³/h"},
+    {REGISTER_RPM_SAF, ModbusRegisterType::READ, REG_SENSOR_RPM_SAF, false, 1.0f,
+     &SaveVTRClimate::rpm_saf_, &SaveVTRClimate::rpm_saf_sensor_, "supply air fan RPM", " RPM"},
+    {REGISTER_RPM_EAF, ModbusRegisterType::READ, REG_SENSOR_RPM_EAF, false, 1.0f,
+     &SaveVTRClimate::rpm_eaf_, &SaveVTRClimate::rpm_eaf_sensor_, "extract air fan RPM", " RPM"},
+    // Decoded separately into the custom fan mode
+    {REGISTER_FAN_MODE, ModbusRegisterType::READ, REG_FAN_MODE, false, 1.0f, nullptr, nullptr, "fan mode", ""},
+};
+
+// Custom fan modes in register order (REG_FAN_MODE reads 0-based, REG_FAN_MODE_REQ takes 1-based)
+static const char *const FAN_MODES[] = {
+    "AUTO-VENT", "MANUAL", "CROWDED", "REFRESH", "FIREPLACE", "AWAY", "HOLIDAY", "COOKERHOOD",
+};
+static constexpr uint16_t FAN_MODE_COUNT = sizeof(FAN_MODES) / sizeof(FAN_MODES[0]);
+
+// Read order when several blocks are waiting: what the climate entity and automations need first
+static uint8_t register_priority(uint8_t id) {
+  switch (id) {
+    case REGISTER_SUPPLY_TEMP:
+      return 0;
+    case REGISTER_SETPOINT:
+      return 1;
+    case REGISTER_OUTDOOR_TEMP:
+      return 2;
+    case REGISTER_FAN_MODE:
+      return 3;
+    default:
+      return id < REGISTER_COUNT ? 4 : 5;
+  }
+}
+
 void SaveVTRClimate::set_modbus(modbus_controller::ModbusController *modbus) {
   this->modbus_ = modbus;
 }
 
+void SaveVTRClimate::set_publish_policy(sensor::Sensor *sensor, float deadband, float relative_deadband,
+                                        uint32_t heartbeat) {
+  for (size_t i = 0; i < DESCRIPTOR_COUNT; i++) {
+    const auto &reg = REGISTERS[i];
+    if (reg.sensor != nullptr && this->*reg.sensor == sensor) {
+      auto &policy = this->publish_policies_[i];
+      policy.deadband = deadband;
+      policy.relative_deadband = relative_deadband;
+      policy.heartbeat = heartbeat;
+    }
+  }
+  if (sensor == this->heat_recovery_efficiency_sensor_) {
+    this->heat_recovery_policy_.deadband = deadband;
+    this->heat_recovery_policy_.relative_deadband = relative_deadband;
+    this->heat_recovery_policy_.heartbeat = heartbeat;
+  }
+}
+
+void SaveVTRClimate::set_poll_interval(RegisterId id, uint32_t interval) {
+  if (this->poll_intervals_[id] == 0 || interval < this->poll_intervals_[id])
+    this->poll_intervals_[id] = interval;
+}
+
 // Ensure we start in HEAT when no state is restored and never expose OFF internally
 void SaveVTRClimate::setup() {
   auto restore = this->restore_state_();
@@ -33,91 +120,208 @@ void SaveVTRClimate::setup() {
   if (this->mode == climate::CLIMATE_MODE_OFF) {
     this->mode = climate::CLIMATE_MODE_HEAT;
   }
-  this->publish_state();
-}
+  this->publish_climate_();
 
-static const char *const TAG = "save_vtr.climate";
+  // Only registers that the climate entity or a configured sensor needs cost bus time
+  for (const auto &reg : REGISTERS) {
+    if (this->polled_registers_ & (1 << reg.id)) {
+      this->cache_.assign(reg.id, reg.register_type, reg.address);
+      this->planner_.add_register(reg.register_type, reg.address, reg.id);
+    }
+  }
+  // Binary sensors share the cache slot of a register that is already polled, or get their own
+  for (auto *sensor : this->binary_sensors_) {
+    uint8_t slot = this->cache_.find_or_add(sensor->get_register_type(), sensor->get_address(), REGISTER_COUNT);
+    if (slot == RegisterCache::NO_SLOT) {
+      ESP_LOGE(TAG, "Register cache full; not polling register %u for '%s'", sensor->get_address(),
+               sensor->get_name().c_str());
+      continue;
+    }
+    sensor->set_cache_slot(slot);
+    this->planner_.add_register(sensor->get_register_type(), sensor->get_address(), slot);
+  }
+  this->planner_.plan();
+  if (this->planner_.blocks().size() > 32) {
+    ESP_LOGE(TAG, "Too many read blocks (%zu); raise max_read_gap", this->planner_.blocks().size());
+    this->mark_failed();
+    return;
+  }
+  this->fieldbus_stats_.set_kind_count(this->planner_.blocks().size());
 
-// Helper function to create temperature read command with /10.0 scaling (for signed 16-bit values)
-template<typename T>
-void create_temperature_read_command(SaveVTRClimate* instance, modbus_controller::ModbusController* modbus,
-                                   modbus_controller::ModbusRegisterType register_type, uint16_t address,
-                                   T* target_variable, const char* log_name) {
-  auto cmd = modbus_controller::ModbusCommandItem::create_read_command(
-    modbus, register_type, address, 1,
-    [instance, target_variable, log_name](modbus_controller::ModbusRegisterType, uint16_t,
-                                        const std::vector<uint8_t> &data) {
-      if (data.size() >= 2) {
-        int16_t temp_raw = static_cast<int16_t>((data[0] << 8) | data[1]);
-        *target_variable = temp_raw / 10.0f;
-        ESP_LOGD(TAG, "Read %s: %.1f°C (raw: %d)", log_name, *target_variable, temp_raw);
-      } else {
-        ESP_LOGE(TAG, "Insufficient data for %s: got %d bytes, expected 2", log_name, data.size());
+  // A block is polled as often as its most demanding member. Blocks whose members all
+  // use the default interval are left to update().
+  const uint32_t default_interval = this->get_update_interval();
+  const auto &registers = this->planner_.registers();
+  for (const auto &block : this->planner_.blocks()) {
+    BlockSchedule sched{0, 0, false};
+    bool has_default = false;
+    for (uint8_t i = block.first; i < block.first + block.size; i++) {
+      uint8_t id = registers[i].id;
+      uint32_t interval = id < REGISTER_COUNT ? this->poll_intervals_[id] : 0;
+      if (interval == 0) {
+        has_default = true;
+      } else if (sched.interval == 0 || interval < sched.interval) {
+        sched.interval = interval;
       }
+      if (FAN_REGISTERS & (1UL << id))
+        sched.fan_related = true;
     }
-  );
-  modbus->queue_command(cmd);
-}
-
-// Helper function to create unsigned 16-bit value read command
-template<typename T>
-void create_uint16_read_command(SaveVTRClimate* instance, modbus_controller::ModbusController* modbus,
-                              modbus_controller::ModbusRegisterType register_type, uint16_t address,
-                              T* target_variable, const char* log_name, const char* unit = "") {
-  auto cmd = modbus_controller::ModbusCommandItem::create_read_command(
-    modbus, register_type, address, 1,
-    [instance, target_variable, log_name, unit](modbus_controller::ModbusRegisterType, uint16_t,
-                                              const std::vector<uint8_t> &data) {
-      if (data.size() >= 2) {
-        uint16_t raw_value = (data[0] << 8) | data[1];
-        *target_variable = static_cast<float>(raw_value);
-        ESP_LOGD(TAG, "Read %s: %.0f%s (raw: %u)", log_name, *target_variable, unit, raw_value);
-      } else {
-        ESP_LOGE(TAG, "Insufficient data for %s: got %d bytes, expected 2", log_name, data.size());
+    if (sched.interval != 0 && has_default && default_interval < sched.interval)
+      sched.interval = default_interval;
+    this->schedule_.push_back(sched);
+  }
+
+  // Build the read commands once; polling only hands copies of them to the controller
+  const auto &blocks = this->planner_.blocks();
+  for (auto &block : this->block_of_)
+    block = NO_COMMAND;
+  for (size_t i = 0; i < blocks.size(); i++) {
+    for (uint8_t r = blocks[i].first; r < blocks[i].first + blocks[i].size; r++)
+      this->block_of_[registers[r].id] = i;
+  }
+  std::vector<uint8_t> block_priority(blocks.size(), UINT8_MAX);
+  for (size_t i = 0; i < blocks.size(); i++) {
+    this->dispatch_order_.push_back(i);
+    for (uint8_t r = blocks[i].first; r < blocks[i].first + blocks[i].size; r++)
+      block_priority[i] = std::min(block_priority[i], register_priority(registers[r].id));
+  }
+  std::stable_sort(this->dispatch_order_.begin(), this->dispatch_order_.end(),
+                   [&block_priority](uint8_t a, uint8_t b) { return block_priority[a] < block_priority[b]; });
+  this->read_commands_.reserve(blocks.size());
+  for (size_t i = 0; i < blocks.size(); i++) {
+    this->read_commands_.push_back(modbus_controller::ModbusCommandItem::create_read_command(
+      this->modbus_, blocks[i].register_type, blocks[i].start_address, blocks[i].register_count,
+      [this, i](ModbusRegisterType, uint16_t, const std::vector<uint8_t> &data) {
+        this->on_block_data_(i, data);
       }
+    ));
+  }
+  // Single-register probe used while the unit is offline
+  this->probe_command_ = modbus_controller::ModbusCommandItem::create_read_command(
+    this->modbus_, ModbusRegisterType::HOLDING, REG_SETPOINT, 1,
+    [this](ModbusRegisterType, uint16_t, const std::vector<uint8_t> &) {
+      if (this->in_flight_ == PROBE_COMMAND) {
+        this->fieldbus_stats_.record_transaction(fieldbus::FieldbusStats::NO_KIND, micros() - this->in_flight_started_us_);
+        this->end_command_();
+      }
+      this->on_answer_();
     }
   );
-  modbus->queue_command(cmd);
+
+  // Publish the last known values until the first poll refreshes them, then poll
+  // everything straight away instead of waiting for the first update_interval
+  this->snapshot_pref_ = global_preferences->make_preference<RegisterSnapshot>(
+      this->get_object_id_hash() ^ fnv1_hash("save_vtr_snapshot"));
+  this->restore_snapshot_();
+  if (this->coordinator_ != nullptr && this->bus_utilization_sensor_ != nullptr)
+    this->coordinator_->set_utilization_sensor(this->bus_utilization_sensor_);
+  const uint32_t now = millis();
+  this->last_snapshot_ = now;
+  uint32_t all = 0;
+  for (size_t i = 0; i < blocks.size(); i++)
+    all |= 1UL << i;
+  this->poll_blocks_(all, now);
+}
+
+void SaveVTRClimate::restore_snapshot_() {
+  if (this->snapshot_interval_ == 0 || !this->snapshot_pref_.load(&this->snapshot_))
+    return;
+  const uint32_t now = millis();
+  uint32_t restored = 0;
+  for (uint8_t id = 0; id < REGISTER_COUNT; id++) {
+    if (this->snapshot_.valid & (1 << id) & this->polled_registers_) {
+      const uint16_t raw = this->snapshot_.raw[id];
+      this->trace_.record(this->block_of_[id], this->cache_[id].address, raw, fieldbus::TRACE_RESTORED, now);
+      this->apply_register_(id, raw, this->trace_.is_enabled() ? nullptr : "Restored");
+      restored |= 1UL << id;
+    }
+  }
+  if (restored == 0)
+    return;
+  // Stale until read from the unit; they are not put in the cache and do not count as fresh
+  this->stale_registers_ = restored;
+  if (restored & (1UL << REGISTER_SUPPLY_TEMP))
+    this->current_temperature = this->supply_air_temp_;
+  for (size_t i = 0; i < DESCRIPTOR_COUNT; i++) {
+    const auto &reg = REGISTERS[i];
+    if (reg.sensor != nullptr && this->*reg.sensor != nullptr && (restored & (1UL << reg.id))) {
+      auto &policy = this->publish_policies_[i];
+      this->publish_sensor_(policy, this->*reg.sensor, this->*reg.target, now);
+      policy.restored = true;
+    }
+  }
+  this->publish_climate_();
+  this->publish_stale_();
+  ESP_LOGI(TAG, "Published %u stale values from the last snapshot", __builtin_popcount(restored));
+}
+
+// Flash wear: only write when a value changed, and at most once per snapshot_interval
+void SaveVTRClimate::save_snapshot_(uint32_t now) {
+  if (this->snapshot_interval_ == 0 || !this->snapshot_dirty_ || now - this->last_snapshot_ < this->snapshot_interval_)
+    return;
+  this->snapshot_pref_.save(&this->snapshot_);
+  this->snapshot_dirty_ = false;
+  this->last_snapshot_ = now;
 }
 
 void SaveVTRClimate::dump_config() {
   ESP_LOGCONFIG(TAG, "SaveVTRClimate:");
   LOG_CLIMATE("  ", "SaveVTRClimate", this);
   ESP_LOGCONFIG(TAG, "  Using Modbus for temperature, setpoint, and fan mode control");
+  static const char *const HEALTH_NAMES[] = {"online", "degraded", "offline"};
+  ESP_LOGCONFIG(TAG, "  Unit: %s (offline after %u unanswered commands, probing every %" PRIu32 "..%" PRIu32 "ms)",
+                HEALTH_NAMES[this->health_], this->offline_after_, this->probe_interval_, this->max_probe_interval_);
+  ESP_LOGCONFIG(TAG, "  Polling %zu registers in %zu reads, cached for %" PRIu32 "ms",
+                this->planner_.registers().size(), this->planner_.blocks().size(), this->cache_.get_ttl());
+  const auto &blocks = this->planner_.blocks();
+  for (size_t i = 0; i < blocks.size() && i < this->schedule_.size(); i++) {
+    const auto &block = blocks[i];
+    ESP_LOGCONFIG(TAG, "    Read type %u: %u..%u (%u registers), every %" PRIu32 "ms%s",
+                  static_cast<uint8_t>(block.register_type), block.start_address,
+                  block.start_address + block.register_count - 1, block.register_count,
+                  this->schedule_[i].interval != 0 ? this->schedule_[i].interval : this->get_update_interval(),
+                  this->schedule_[i].fan_related ? " (fan boost)" : "");
+  }
+  if (this->fan_boost_duration_ > 0) {
+    ESP_LOGCONFIG(TAG, "  Fan boost: every %" PRIu32 "ms for %" PRIu32 "ms after a fan mode change",
+                  this->fan_boost_interval_, this->fan_boost_duration_);
+  }
+  this->fieldbus_stats_.dump_config(TAG);
+  this->trace_.dump_config(TAG);
+  for (size_t i = 0; i < blocks.size() && i < this->fieldbus_stats_.kind_count(); i++) {
+    const std::string label = str_sprintf("Read %u..%u", blocks[i].start_address,
+                                          blocks[i].start_address + blocks[i].register_count - 1);
+    this->fieldbus_stats_.kind(i).dump(TAG, label.c_str());
+  }
   ESP_LOGCONFIG(TAG, "  Heat demand: %.0f%%", this->heat_demand_percent_);
   ESP_LOGCONFIG(TAG, "  Supply Air Flow: %.1f m³/h", this->saf_volume_);
   ESP_LOGCONFIG(TAG, "  Extract Air Flow: %.1f m³/h", this->eaf_volume_);
   ESP_LOGCONFIG(TAG, "  Outdoor Air Temp: %.1f°C", this->outdoor_air_temp_);
   ESP_LOGCONFIG(TAG, "  Supply Air Temp: %.1f°C", this->supply_air_temp_);
   ESP_LOGCONFIG(TAG, "  Extract Air Temp: %.1f°C", this->extract_air_temp_);
+  if (this->heat_recovery_efficiency_sensor_ != nullptr)
+    ESP_LOGCONFIG(TAG, "  Heat recovery efficiency: %.0f%%", this->heat_recovery_efficiency_);
+  for (auto &entry : this->aggregators_)
+    entry.second->dump_config(entry.first->get_name().c_str());
+  for (auto *sensor : this->binary_sensors_)
+    sensor->dump_config();
+  if (this->coordinator_ != nullptr)
+    ESP_LOGCONFIG(TAG, "  Shared bus: unit %u, polling at its own phase of update_interval", this->bus_unit_);
+  LOG_BINARY_SENSOR("  ", "Stale", this->stale_sensor_);
 }
 
 
 // Map register value to custom fan mode string
-static std::string reg_to_fan_mode_string(int reg) {
-  switch (reg) {
-    case 0: return "AUTO-VENT";
-    case 1: return "MANUAL";
-    case 2: return "CROWDED";
-    case 3: return "REFRESH";
-    case 4: return "FIREPLACE";
-    case 5: return "AWAY";
-    case 6: return "HOLIDAY";
-    case 7: return "COOKERHOOD";
-    default: return "AUTO-VENT";
-  }
+static const char *reg_to_fan_mode_string(uint16_t reg) {
+  return reg < FAN_MODE_COUNT ? FAN_MODES[reg] : FAN_MODES[0];
 }
 
 // Map custom fan mode string to register value
 static int fan_mode_to_reg(const std::string &mode) {
-  if (mode == "AUTO-VENT") return 1;
-  if (mode == "MANUAL") return 2;
-  if (mode == "CROWDED") return 3;
-  if (mode == "REFRESH") return 4;
-  if (mode == "FIREPLACE") return 5;
-  if (mode == "AWAY") return 6;
-  if (mode == "HOLIDAY") return 7;
-  if (mode == "COOKERHOOD") return 8; // read-only, do not write
+  for (uint16_t i = 0; i < FAN_MODE_COUNT; i++) {
+    if (mode == FAN_MODES[i])
+      return i + 1;  // COOKERHOOD (8) is read-only, do not write
+  }
   return 0;
 }
 
@@ -153,10 +357,7 @@ void SaveVTRClimate::control(const climate::ClimateCall &call) {
   if (call.get_target_temperature().has_value()) {
     float temp = *call.get_target_temperature();
     ESP_LOGI(TAG, "Setting target temperature: %.1f", temp);
-    auto cmd = modbus_controller::ModbusCommandItem::create_write_single_command(
-      this->modbus_, REG_SETPOINT, static_cast<uint16_t>(temp * 10)
-    );
-    this->modbus_->queue_command(cmd);
+    this->queue_write_(REG_SETPOINT, static_cast<uint16_t>(temp * 10), REGISTER_SETPOINT);
     this->target_temperature = temp;
   }
 
@@ -166,10 +367,8 @@ void SaveVTRClimate::control(const climate::ClimateCall &call) {
     ESP_LOGI(TAG, "Requested custom fan mode change to: %s", mode.c_str());
     int reg_val = fan_mode_to_reg(mode);
     if (reg_val >= 1 && reg_val <= 7) {
-      auto cmd = modbus_controller::ModbusCommandItem::create_write_single_command(
-        this->modbus_, REG_FAN_MODE_REQ, static_cast<uint16_t>(reg_val)
-      );
-      this->modbus_->queue_command(cmd);
+      this->queue_write_(REG_FAN_MODE_REQ, static_cast<uint16_t>(reg_val), REGISTER_FAN_MODE);
+      this->start_fan_boost_();
     } else if (reg_val == 8) {
       ESP_LOGW(TAG, "COOKERHOOD mode is read-only on Modbus; skipping write");
     } else {
@@ -177,95 +376,647 @@ void SaveVTRClimate::control(const climate::ClimateCall &call) {
     }
   }
 
-  this->publish_state();
+  this->publish_climate_();
 }
 
+// Writes go into their own lane, which is always dispatched ahead of pending reads.
+// A write only becomes ready after write_debounce; repeated writes to the same register
+// within that window collapse into the latest value.
+void SaveVTRClimate::queue_write_(uint16_t address, uint16_t value, RegisterId readback) {
+  const uint32_t ready_at = millis() + this->write_debounce_;
+  for (uint8_t i = 0; i < this->write_count_; i++) {
+    auto &write = this->writes_[i];
+    if (write.address == address) {
+      ESP_LOGD(TAG, "Coalescing write to register %u: %u -> %u", address, write.value, value);
+      write.value = value;
+      write.ready_at = ready_at;
+      write.attempts = 0;
+      return;
+    }
+  }
+  if (this->write_count_ == MAX_PENDING_WRITES) {
+    ESP_LOGW(TAG, "Write queue full; dropping oldest write to register %u", this->writes_[0].address);
+    this->remove_writes_(1);
+  }
+  this->writes_[this->write_count_++] = PendingWrite{address, value, readback, ready_at, 0};
+}
 
-void SaveVTRClimate::update() {
-  if (this->modbus_ != nullptr) {
-    // ...existing code for modbus reads...
-    create_temperature_read_command(this, this->modbus_, modbus_controller::ModbusRegisterType::HOLDING, 
-                                  REG_SETPOINT, &this->target_temperature, "setpoint");
-    create_temperature_read_command(this, this->modbus_, modbus_controller::ModbusRegisterType::HOLDING, 
-                                  REG_OUTDOOR_TEMP, &this->outdoor_air_temp_, "outdoor air temperature");
-    create_temperature_read_command(this, this->modbus_, modbus_controller::ModbusRegisterType::HOLDING,
-                                  REG_SUPPLY_TEMP, &this->supply_air_temp_, "supply air temperature");
-    this->current_temperature = this->supply_air_temp_;
-    create_temperature_read_command(this, this->modbus_, modbus_controller::ModbusRegisterType::HOLDING, 
-                                  REG_EXTRACT_TEMP, &this->extract_air_temp_, "extract air temperature");
-    create_uint16_read_command(this, this->modbus_, modbus_controller::ModbusRegisterType::READ,
-                             REG_HEAT_DEMAND, &this->heat_demand_percent_, "heat demand", "%");
-    auto cmd_saf = modbus_controller::ModbusCommandItem::create_read_command(
-      this->modbus_, modbus_controller::ModbusRegisterType::READ, REG_SUPPLY_AIRFLOW, 1,
-      [this](modbus_controller::ModbusRegisterType, uint16_t, const std::vector<uint8_t> &data) {
-        if (data.size() >= 2) {
-          uint16_t saf_raw = (data[0] << 8) | data[1];
-          this->saf_volume_ = static_cast<float>(saf_raw) * 3.0f;
-          this->saf_percent_ = static_cast<float>(saf_raw);
-          ESP_LOGD(TAG, "Read supply air flow: %.1f m³/h (raw: %u)", this->saf_volume_, saf_raw);
-          if (this->saf_volume_sensor_ != nullptr)
-            this->saf_volume_sensor_->publish_state(this->saf_volume_);
-          if (this->saf_percent_sensor_ != nullptr)
-            this->saf_percent_sensor_->publish_state(this->saf_percent_);
-        } else {
-          ESP_LOGE(TAG, "Insufficient data for supply air flow: got %d bytes, expected 2", data.size());
-        }
-      }
-    );
-    this->modbus_->queue_command(cmd_saf);
-    auto cmd_eaf = modbus_controller::ModbusCommandItem::create_read_command(
-      this->modbus_, modbus_controller::ModbusRegisterType::READ, REG_EXTRACT_AIRFLOW, 1,
-      [this](modbus_controller::ModbusRegisterType, uint16_t, const std::vector<uint8_t> &data) {
-        if (data.size() >= 2) {
-          uint16_t eaf_raw = (data[0] << 8) | data[1];
-          this->eaf_volume_ = static_cast<float>(eaf_raw) * 3.0f;
-          this->eaf_percent_ = static_cast<float>(eaf_raw);
-          ESP_LOGD(TAG, "Read extract air flow: %.1f m³/h (raw: %u)", this->eaf_volume_, eaf_raw);
-          if (this->eaf_volume_sensor_ != nullptr)
-            this->eaf_volume_sensor_->publish_state(this->eaf_volume_);
-          if (this->eaf_percent_sensor_ != nullptr)
-            this->eaf_percent_sensor_->publish_state(this->eaf_percent_);
-        } else {
-          ESP_LOGE(TAG, "Insufficient data for extract air flow: got %d bytes, expected 2", data.size());
-        }
-      }
-    );
-    this->modbus_->queue_command(cmd_eaf);
-    create_uint16_read_command(this, this->modbus_, modbus_controller::ModbusRegisterType::READ,
-                             REG_SENSOR_RPM_SAF, &this->rpm_saf_, "supply air fan RPM", " RPM");
-    create_uint16_read_command(this, this->modbus_, modbus_controller::ModbusRegisterType::READ,
-                             REG_SENSOR_RPM_EAF, &this->rpm_eaf_, "extract air fan RPM", " RPM");
-    auto cmd_fan = modbus_controller::ModbusCommandItem::create_read_command(
-      this->modbus_, modbus_controller::ModbusRegisterType::READ, REG_FAN_MODE, 1,
-      [this](modbus_controller::ModbusRegisterType, uint16_t, const std::vector<uint8_t> &data) {
-        if (data.size() >= 2) {
-          uint16_t fanmode_raw = (data[0] << 8) | data[1];
-          this->set_custom_fan_mode_(reg_to_fan_mode_string(fanmode_raw).c_str());
-          ESP_LOGD(TAG, "Read fan mode: %s (%d)", this->get_custom_fan_mode().c_str(), fanmode_raw);
-        } else {
-          ESP_LOGE(TAG, "Insufficient data for fan mode: got %d bytes, expected 2", data.size());
-        }
+// Drop the pending writes selected by a bitmask of queue positions, keeping the order
+void SaveVTRClimate::remove_writes_(uint8_t mask) {
+  uint8_t kept = 0;
+  for (uint8_t i = 0; i < this->write_count_; i++) {
+    if ((mask & (1 << i)) == 0)
+      this->writes_[kept++] = this->writes_[i];
+  }
+  this->write_count_ = kept;
+}
+
+// The writes of a frame that was not answered go back into the lane, ready straight away,
+// unless a newer value for the register was queued meanwhile. After MAX_WRITE_ATTEMPTS the
+// write is dropped and the climate shows the value last read from the unit again.
+void SaveVTRClimate::retry_writes_(uint32_t now) {
+  for (uint8_t i = 0; i < this->sent_write_count_; i++) {
+    PendingWrite write = this->sent_writes_[i];
+    bool superseded = false;
+    for (uint8_t j = 0; j < this->write_count_; j++)
+      superseded |= this->writes_[j].address == write.address;
+    if (superseded)
+      continue;
+    if (++write.attempts < MAX_WRITE_ATTEMPTS && this->write_count_ < MAX_PENDING_WRITES) {
+      this->fieldbus_stats_.record_retry();
+      write.ready_at = now;
+      this->writes_[this->write_count_++] = write;
+      continue;
+    }
+    ESP_LOGW(TAG, "Giving up on writing %u to register %u", write.value, write.address);
+    uint16_t raw;
+    if (this->cache_.get(write.readback, &raw)) {
+      this->apply_register_(write.readback, raw, "Restored");
+      this->publish_climate_();
+    }
+  }
+  this->sent_write_count_ = 0;
+}
+
+// Split a block response back into its registers
+void SaveVTRClimate::on_block_data_(size_t block_index, const std::vector<uint8_t> &data) {
+  const auto &block = this->planner_.blocks()[block_index];
+  const auto &registers = this->planner_.registers();
+  if (this->in_flight_ == block_index)
+    this->fieldbus_stats_.record_transaction(block_index, micros() - this->in_flight_started_us_);
+  if (data.size() < block.register_count * 2u)
+    this->fieldbus_stats_.record_error(fieldbus::ERROR_SHORT_RESPONSE);
+  for (uint8_t i = block.first; i < block.first + block.size; i++) {
+    const auto &reg = registers[i];
+    size_t offset = RegisterPlanner::offset_of(block, reg);
+    if (data.size() < offset + 2) {
+      ESP_LOGE(TAG, "Insufficient data for register %u: got %zu bytes, expected %u", reg.address, data.size(),
+               block.register_count * 2);
+      this->trace_.record(block_index, reg.address, 0, fieldbus::TRACE_SHORT_RESPONSE, millis());
+      continue;
+    }
+    const uint16_t raw = (data[offset] << 8) | data[offset + 1];
+    this->trace_.record(block_index, reg.address, raw, fieldbus::TRACE_OK, millis());
+    this->decode_register_(reg.id, raw);
+  }
+  if (this->in_flight_ == block_index)
+    this->end_command_();
+  this->on_answer_();
+
+  // Late answers from a cycle that already hit its deadline are decoded but not counted
+  uint32_t bit = 1UL << block_index;
+  if (!this->cycle_active_ || (this->pending_blocks_ & bit) == 0)
+    return;
+  this->pending_blocks_ &= ~bit;
+  if (this->pending_blocks_ == 0)
+    this->finish_cycle_(false);
+}
+
+// Hand the next command to the controller once the previous one answered or timed out.
+// Only one command of this component sits in the controller queue at a time, so a
+// write never waits behind more than one poll read.
+void SaveVTRClimate::dispatch_(uint32_t now) {
+  if (this->in_flight_ != NO_COMMAND) {
+    if (now - this->in_flight_since_ < this->command_timeout_)
+      return;
+    this->on_command_timeout_(now);
+  }
+
+  // With other units on the bus, wait for this unit's turn; writes and read-backs are urgent
+  bool urgent = false;
+  bool has_work;
+  if (this->health_ == HEALTH_OFFLINE) {
+    has_work = static_cast<int32_t>(now - this->next_probe_) >= 0;
+  } else {
+    urgent = this->first_ready_write_(now) != MAX_PENDING_WRITES || this->readback_lane_ != 0;
+    has_work = urgent || this->read_lane_ != 0;
+  }
+  if (this->coordinator_ != nullptr) {
+    if (!has_work) {
+      this->coordinator_->idle(this->bus_unit_);
+      return;
+    }
+    if (!this->coordinator_->try_acquire(this->bus_unit_, urgent, now))
+      return;
+  }
+
+  if (this->health_ == HEALTH_OFFLINE) {
+    if (has_work) {
+      this->modbus_->queue_command(this->probe_command_);
+      this->in_flight_ = PROBE_COMMAND;
+      this->in_flight_since_ = now;
+      this->in_flight_started_us_ = micros();
+    }
+    return;
+  }
+
+  if (this->dispatch_write_(now))
+    return;
+
+  uint32_t lane = this->readback_lane_ != 0 ? this->readback_lane_ : this->read_lane_;
+  if (lane == 0)
+    return;
+  uint8_t block = 0;
+  for (uint8_t i : this->dispatch_order_) {
+    if (lane & (1UL << i)) {
+      block = i;
+      break;
+    }
+  }
+  this->readback_lane_ &= ~(1UL << block);
+  this->read_lane_ &= ~(1UL << block);
+  this->modbus_->queue_command(this->read_commands_[block]);
+  this->in_flight_ = block;
+  this->in_flight_since_ = now;
+  this->in_flight_started_us_ = micros();
+}
+
+void SaveVTRClimate::on_command_timeout_(uint32_t now) {
+  const uint8_t command = this->in_flight_;
+  this->end_command_();
+  this->fieldbus_stats_.record_error(fieldbus::ERROR_TIMEOUT);
+  if (command < this->planner_.blocks().size())
+    this->trace_.record(command, this->planner_.blocks()[command].start_address, 0, fieldbus::TRACE_TIMEOUT, now);
+  if (this->consecutive_timeouts_ < UINT8_MAX)
+    this->consecutive_timeouts_++;
+
+  if (command == PROBE_COMMAND) {
+    // The next probe repeats this one
+    this->fieldbus_stats_.record_retry();
+    this->probe_backoff_ = std::min(this->probe_backoff_ * 2, this->max_probe_interval_);
+    this->next_probe_ = now + this->probe_backoff_;
+    ESP_LOGD(TAG, "Unit still offline; next probe in %" PRIu32 "ms", this->probe_backoff_);
+    return;
+  }
+  ESP_LOGW(TAG, "No answer to %s within %" PRIu32 "ms", command == WRITE_COMMAND ? "write" : "read",
+           this->command_timeout_);
+  if (command == WRITE_COMMAND)
+    this->retry_writes_(now);
+  if (this->consecutive_timeouts_ >= this->offline_after_) {
+    this->go_offline_(now);
+  } else if (this->health_ == HEALTH_ONLINE) {
+    this->health_ = HEALTH_DEGRADED;
+  }
+}
+
+void SaveVTRClimate::on_answer_() {
+  this->consecutive_timeouts_ = 0;
+  if (this->health_ == HEALTH_OFFLINE) {
+    this->go_online_();
+  } else {
+    this->health_ = HEALTH_ONLINE;
+  }
+}
+
+// Stop regular polling, mark every value unavailable and start probing with backoff
+void SaveVTRClimate::go_offline_(uint32_t now) {
+  ESP_LOGW(TAG, "Unit not responding after %u commands; marking offline", this->consecutive_timeouts_);
+  this->health_ = HEALTH_OFFLINE;
+  this->status_set_warning();
+  this->read_lane_ = 0;
+  this->readback_lane_ = 0;
+  if (this->cycle_active_) {
+    this->cycle_active_ = false;
+    this->pending_blocks_ = 0;
+  }
+  this->probe_backoff_ = this->probe_interval_;
+  this->next_probe_ = now + this->probe_backoff_;
+
+  this->cache_.invalidate_all();
+  for (size_t i = 0; i < DESCRIPTOR_COUNT; i++) {
+    const auto &reg = REGISTERS[i];
+    if (reg.sensor != nullptr && this->*reg.sensor != nullptr)
+      this->publish_sensor_(this->publish_policies_[i], this->*reg.sensor, NAN, now);
+  }
+  if (this->heat_recovery_efficiency_sensor_ != nullptr)
+    this->publish_sensor_(this->heat_recovery_policy_, this->heat_recovery_efficiency_sensor_, NAN, now);
+  for (auto *sensor : this->binary_sensors_)
+    sensor->invalidate_state();
+  this->current_temperature = NAN;
+  this->publish_climate_();
+  // Unavailable, not stale: nothing shows an old value as current any more
+  this->stale_registers_ = 0;
+  this->publish_stale_();
+}
+
+// The unit answered again: resume full polling straight away
+void SaveVTRClimate::go_online_() {
+  ESP_LOGI(TAG, "Unit responding again; resuming polling");
+  this->health_ = HEALTH_ONLINE;
+  this->status_clear_warning();
+  const uint32_t now = millis();
+  uint32_t all = 0;
+  for (size_t i = 0; i < this->schedule_.size(); i++)
+    all |= 1UL << i;
+  this->poll_blocks_(all, now);
+  this->next_poll_ = now;
+}
+
+// Position of the first write whose debounce window has passed, MAX_PENDING_WRITES if none
+uint8_t SaveVTRClimate::first_ready_write_(uint32_t now) const {
+  for (uint8_t i = 0; i < this->write_count_; i++) {
+    if (static_cast<int32_t>(now - this->writes_[i].ready_at) >= 0)
+      return i;
+  }
+  return MAX_PENDING_WRITES;
+}
+
+// The command in flight answered or timed out: free the bus for the next one
+void SaveVTRClimate::end_command_() {
+  this->in_flight_ = NO_COMMAND;
+  if (this->coordinator_ != nullptr)
+    this->coordinator_->release(this->bus_unit_, millis());
+}
+
+// Send the first write whose debounce window has passed. Other ready writes to adjacent
+// registers are merged into the same Write Multiple Registers (function 16) frame.
+bool SaveVTRClimate::dispatch_write_(uint32_t now) {
+  const uint8_t first = this->first_ready_write_(now);
+  if (first == MAX_PENDING_WRITES)
+    return false;
+
+  uint16_t start = this->writes_[first].address;
+  uint16_t end = start;  // inclusive
+  uint8_t taken = 1 << first;
+  bool grown = this->write_multiple_;
+  while (grown) {
+    grown = false;
+    for (uint8_t i = 0; i < this->write_count_; i++) {
+      const auto &write = this->writes_[i];
+      if ((taken & (1 << i)) || static_cast<int32_t>(now - write.ready_at) < 0)
+        continue;
+      if (write.address == end + 1 || write.address + 1 == start) {
+        start = std::min(start, write.address);
+        end = std::max(end, write.address);
+        taken |= 1 << i;
+        grown = true;
       }
-    );
-    this->modbus_->queue_command(cmd_fan);
+    }
+  }
+
+  uint16_t values[MAX_PENDING_WRITES];
+  uint16_t readback = 0;
+  this->sent_write_count_ = 0;
+  for (uint8_t i = 0; i < this->write_count_; i++) {
+    if (taken & (1 << i)) {
+      values[this->writes_[i].address - start] = this->writes_[i].value;
+      readback |= 1 << this->writes_[i].readback;
+      this->sent_writes_[this->sent_write_count_++] = this->writes_[i];
+    }
+  }
+  this->remove_writes_(taken);
+
+  const uint16_t count = end - start + 1;
+  modbus_controller::ModbusCommandItem cmd;
+  if (count == 1) {
+    cmd = modbus_controller::ModbusCommandItem::create_write_single_command(this->modbus_, start, values[0]);
+  } else {
+    ESP_LOGD(TAG, "Writing %u registers from %u in one frame", count, start);
+    cmd = modbus_controller::ModbusCommandItem::create_write_multiple_command(
+      this->modbus_, start, count, std::vector<uint16_t>(values, values + count));
+  }
+  cmd.on_data_func = [this, readback](ModbusRegisterType, uint16_t, const std::vector<uint8_t> &) {
+    this->on_write_done_(readback);
+  };
+  this->modbus_->queue_command(cmd);
+  this->in_flight_ = WRITE_COMMAND;
+  this->in_flight_since_ = now;
+  this->in_flight_started_us_ = micros();
+  return true;
+}
+
+// A write was acknowledged: read the affected registers back before any other pending read
+void SaveVTRClimate::on_write_done_(uint16_t readback) {
+  if (this->in_flight_ == WRITE_COMMAND) {
+    this->fieldbus_stats_.record_transaction(fieldbus::FieldbusStats::NO_KIND, micros() - this->in_flight_started_us_);
+    this->end_command_();
+  }
+  this->on_answer_();
+  const uint32_t now = millis();
+  uint32_t blocks = 0;
+  for (uint8_t id = 0; id < REGISTER_COUNT; id++) {
+    if ((readback & (1 << id)) && this->block_of_[id] != NO_COMMAND)
+      blocks |= 1UL << this->block_of_[id];
+  }
+  this->readback_lane_ |= blocks;
+  this->poll_blocks_(blocks, now);
+  this->dispatch_(now);
+}
+
+static bool same_value(float a, float b) { return a == b || (std::isnan(a) && std::isnan(b)); }
+
+// Publish a sensor value only when it moved past its deadband or its heartbeat expired.
+// Going to or from NAN (unit offline) and replacing a restored value always count as a change.
+void SaveVTRClimate::publish_sensor_(PublishPolicy &policy, sensor::Sensor *sensor, float value, uint32_t now) {
+  bool changed;
+  if (policy.restored) {
+    changed = true;
+  } else if (std::isnan(value) || std::isnan(policy.last_value)) {
+    changed = std::isnan(value) != std::isnan(policy.last_value);
+  } else {
+    const float threshold = std::max(policy.deadband, policy.relative_deadband * std::fabs(policy.last_value));
+    changed = std::fabs(value - policy.last_value) > threshold;
+  }
+  const bool heartbeat_due = policy.heartbeat != 0 && now - policy.last_publish >= policy.heartbeat;
+  if (!changed && !heartbeat_due)
+    return;
+  policy.last_value = value;
+  policy.last_publish = now;
+  policy.restored = false;
+  sensor->publish_state(value);
+}
+
+// Heartbeats expire between samples too, e.g. with a long update_interval or while the
+// unit is offline, so they are checked from loop(), once a second
+void SaveVTRClimate::check_heartbeats_(uint32_t now) {
+  if (now - this->last_heartbeat_check_ < 1000)
+    return;
+  this->last_heartbeat_check_ = now;
+  for (size_t i = 0; i < DESCRIPTOR_COUNT; i++) {
+    const auto &reg = REGISTERS[i];
+    if (reg.sensor != nullptr && this->*reg.sensor != nullptr)
+      this->republish_(this->publish_policies_[i], this->*reg.sensor, now);
+  }
+  if (this->heat_recovery_efficiency_sensor_ != nullptr)
+    this->republish_(this->heat_recovery_policy_, this->heat_recovery_efficiency_sensor_, now);
+}
+
+// Publish the last published value again if its heartbeat expired
+void SaveVTRClimate::republish_(PublishPolicy &policy, sensor::Sensor *sensor, uint32_t now) {
+  if (policy.heartbeat == 0 || !sensor->has_state() || now - policy.last_publish < policy.heartbeat)
+    return;
+  policy.last_publish = now;
+  sensor->publish_state(policy.last_value);
+}
+
+// A fresh value: every sample goes to the aggregators, the sensor itself only past its deadband
+void SaveVTRClimate::on_sample_(PublishPolicy &policy, sensor::Sensor *sensor, float value, uint32_t now) {
+  for (auto &entry : this->aggregators_) {
+    if (entry.first == sensor)
+      entry.second->add_sample(value, now);
+  }
+  this->publish_sensor_(policy, sensor, value, now);
+}
+
+// Values computed on device from several registers, once per cycle in which any input changed
+void SaveVTRClimate::update_derived_(uint32_t now) {
+  static constexpr uint32_t TEMPERATURES =
+      (1UL << REGISTER_OUTDOOR_TEMP) | (1UL << REGISTER_SUPPLY_TEMP) | (1UL << REGISTER_EXTRACT_TEMP);
+  if (this->heat_recovery_efficiency_sensor_ == nullptr || (this->fresh_registers_ & TEMPERATURES) == 0)
+    return;
+  uint16_t raw;
+  if (!this->cache_.get(REGISTER_OUTDOOR_TEMP, &raw) || !this->cache_.get(REGISTER_SUPPLY_TEMP, &raw) ||
+      !this->cache_.get(REGISTER_EXTRACT_TEMP, &raw))
+    return;
+  // Supply-side temperature efficiency. Meaningless when indoor and outdoor are nearly equal.
+  const float span = this->extract_air_temp_ - this->outdoor_air_temp_;
+  if (std::fabs(span) < 2.0f)
+    return;
+  this->heat_recovery_efficiency_ = (this->supply_air_temp_ - this->outdoor_air_temp_) / span * 100.0f;
+  this->on_sample_(this->heat_recovery_policy_, this->heat_recovery_efficiency_sensor_,
+                   this->heat_recovery_efficiency_, now);
+}
+
+// Publish the climate entity only when one of its fields changed
+void SaveVTRClimate::publish_climate_() {
+  if (this->climate_published_ && same_value(this->current_temperature, this->published_current_temperature_) &&
+      same_value(this->target_temperature, this->published_target_temperature_) &&
+      this->mode == this->published_mode_ && this->fan_mode_raw_ == this->published_fan_mode_raw_)
+    return;
+  this->climate_published_ = true;
+  this->published_current_temperature_ = this->current_temperature;
+  this->published_target_temperature_ = this->target_temperature;
+  this->published_mode_ = this->mode;
+  this->published_fan_mode_raw_ = this->fan_mode_raw_;
+  this->publish_state();
+}
+
+// Publish everything read in this cycle. Registers that did not answer before the
+// deadline keep their previous state instead of being republished as fresh, and count
+// as stale until they are read again.
+void SaveVTRClimate::finish_cycle_(bool timed_out) {
+  this->cycle_active_ = false;
+  const auto &blocks = this->planner_.blocks();
+  const auto &registers = this->planner_.registers();
+  for (size_t b = 0; b < blocks.size(); b++) {
+    if ((this->cycle_blocks_ & (1UL << b)) == 0)
+      continue;
+    for (uint8_t i = blocks[b].first; i < blocks[b].first + blocks[b].size; i++) {
+      if ((this->fresh_registers_ & (1UL << registers[i].id)) == 0)
+        this->stale_registers_ |= 1UL << registers[i].id;
+    }
   }
-  this->set_timeout(100, [this]() {
+  if (timed_out) {
+    // Do not let reads that never got on the bus pile up behind an unresponsive unit
+    this->read_lane_ = 0;
+    ESP_LOGW(TAG, "Poll cycle timed out with %u reads outstanding (stale registers: 0x%08" PRIX32 ")",
+             __builtin_popcount(this->pending_blocks_), this->stale_registers_);
+  }
+  this->pending_blocks_ = 0;
+
+  const uint32_t now = millis();
+  this->fieldbus_stats_.record_cycle((now - this->cycle_start_) * 1000);
+
+  if (this->fresh_registers_ & (1UL << REGISTER_SUPPLY_TEMP))
     this->current_temperature = this->supply_air_temp_;
-    // Publish sensors for other values
-    if (this->heat_demand_sensor_ != nullptr)
-      this->heat_demand_sensor_->publish_state(this->heat_demand_percent_);
-    if (this->outdoor_air_temp_sensor_ != nullptr)
-      this->outdoor_air_temp_sensor_->publish_state(this->outdoor_air_temp_);
-    if (this->supply_air_temp_sensor_ != nullptr)
-      this->supply_air_temp_sensor_->publish_state(this->supply_air_temp_);
-    if (this->extract_air_temp_sensor_ != nullptr)
-      this->extract_air_temp_sensor_->publish_state(this->extract_air_temp_);
-    if (this->rpm_saf_sensor_ != nullptr)
-      this->rpm_saf_sensor_->publish_state(this->rpm_saf_);
-    if (this->rpm_eaf_sensor_ != nullptr)
-      this->rpm_eaf_sensor_->publish_state(this->rpm_eaf_);
-    this->publish_state();
-  });
+  for (size_t i = 0; i < DESCRIPTOR_COUNT; i++) {
+    const auto &reg = REGISTERS[i];
+    if (reg.sensor != nullptr && this->*reg.sensor != nullptr && (this->fresh_registers_ & (1UL << reg.id)))
+      this->on_sample_(this->publish_policies_[i], this->*reg.sensor, this->*reg.target, now);
+  }
+  this->update_derived_(now);
+  uint16_t raw;
+  for (auto *sensor : this->binary_sensors_) {
+    const uint8_t slot = sensor->get_cache_slot();
+    if (slot != RegisterCache::NO_SLOT && (this->fresh_registers_ & (1UL << slot)) && this->cache_.get(slot, &raw))
+      sensor->on_register_value(raw);
+  }
+  this->publish_climate_();
+  this->publish_stale_();
+  this->save_snapshot_(now);
+}
+
+void SaveVTRClimate::publish_stale_() {
+  if (this->stale_sensor_ != nullptr)
+    this->stale_sensor_->publish_state(this->stale_registers_ != 0);
+}
+
+void SaveVTRClimate::dump_trace() { this->trace_.dump(TAG); }
+
+void SaveVTRClimate::decode_register_(uint8_t id, uint16_t raw) {
+  this->cache_.store(id, raw, millis());
+  // Traced reads were already recorded; skip the per-register log line
+  this->apply_register_(id, raw, this->trace_.is_enabled() ? nullptr : "Read");
+  this->fresh_registers_ |= 1UL << id;
+  this->stale_registers_ &= ~(1UL << id);
+  if (id < REGISTER_COUNT && ((this->snapshot_.valid & (1 << id)) == 0 || this->snapshot_.raw[id] != raw)) {
+    this->snapshot_.valid |= 1 << id;
+    this->snapshot_.raw[id] = raw;
+    this->snapshot_dirty_ = true;
+  }
+}
+
+// Decode a raw register value into the climate fields and sensor values it feeds
+void SaveVTRClimate::apply_register_(uint8_t id, uint16_t raw, const char *source) {
+  for (const auto &reg : REGISTERS) {
+    if (reg.id != id || reg.target == nullptr)
+      continue;
+    float value = (reg.is_signed ? static_cast<int16_t>(raw) : raw) * reg.scale;
+    this->*reg.target = value;
+    if (source != nullptr)
+      ESP_LOGD(TAG, "%s %s: %.1f%s (raw: %u)", source, reg.name, value, reg.unit, raw);
+  }
+  // Only touch the custom fan mode when it changes; resolving it walks the traits
+  if (id == REGISTER_FAN_MODE && raw != this->fan_mode_raw_) {
+    this->fan_mode_raw_ = raw;
+    this->set_custom_fan_mode_(reg_to_fan_mode_string(raw));
+    if (source != nullptr)
+      ESP_LOGD(TAG, "%s fan mode: %s (%d)", source, reg_to_fan_mode_string(raw), raw);
+  }
+}
+
+// Every register of the block was read within the cache TTL
+bool SaveVTRClimate::block_cached_(size_t block_index, uint32_t now) const {
+  const auto &block = this->planner_.blocks()[block_index];
+  const auto &registers = this->planner_.registers();
+  for (uint8_t i = block.first; i < block.first + block.size; i++) {
+    if (!this->cache_.is_fresh(registers[i].id, now))
+      return false;
+  }
+  return true;
+}
+
+// Effective polling interval of a block right now; 0 means it is only polled by update()
+uint32_t SaveVTRClimate::block_interval_(size_t block_index, uint32_t now) const {
+  const auto &sched = this->schedule_[block_index];
+  uint32_t interval = sched.interval;
+  bool boosted = static_cast<int32_t>(this->fan_boost_until_ - now) > 0;
+  if (boosted && sched.fan_related && (interval == 0 || this->fan_boost_interval_ < interval))
+    interval = this->fan_boost_interval_;
+  return interval;
+}
+
+void SaveVTRClimate::start_fan_boost_() {
+  if (this->fan_boost_duration_ == 0)
+    return;
+  const uint32_t now = millis();
+  this->fan_boost_until_ = now + this->fan_boost_duration_;
+  const uint32_t next_due = now + this->fan_boost_interval_;
+  for (auto &sched : this->schedule_) {
+    if (sched.fan_related && static_cast<int32_t>(sched.next_due - next_due) > 0)
+      sched.next_due = next_due;
+  }
+  if (static_cast<int32_t>(this->next_poll_ - next_due) > 0)
+    this->next_poll_ = next_due;
+}
+
+// Deadline scheduler for blocks that have their own interval (or are boosted)
+void SaveVTRClimate::loop() {
+  if (this->modbus_ == nullptr || this->schedule_.empty())
+    return;
+  const uint32_t now = millis();
+  for (auto &entry : this->aggregators_)
+    entry.second->check_window(now);
+  this->check_heartbeats_(now);
+  if (this->cycle_active_ && static_cast<int32_t>(now - this->cycle_deadline_) >= 0)
+    this->finish_cycle_(true);
+  this->dispatch_(now);
+  // Format trace events only while nothing of ours waits on the bus
+  if (this->in_flight_ == NO_COMMAND)
+    this->trace_.flush_idle(TAG);
+  if (this->health_ == HEALTH_OFFLINE)
+    return;
+  if (this->update_pending_ && static_cast<int32_t>(now - this->update_due_) >= 0) {
+    this->update_pending_ = false;
+    this->poll_default_blocks_(now);
+  }
+  if (static_cast<int32_t>(now - this->next_poll_) < 0)
+    return;
+
+  uint32_t due = 0;
+  uint32_t next_poll = now + 60000;
+  for (size_t i = 0; i < this->schedule_.size(); i++) {
+    if (this->block_interval_(i, now) == 0)
+      continue;
+    const auto &sched = this->schedule_[i];
+    if (static_cast<int32_t>(now - sched.next_due) >= 0) {
+      due |= 1UL << i;
+    } else if (static_cast<int32_t>(next_poll - sched.next_due) > 0) {
+      next_poll = sched.next_due;
+    }
+  }
+  this->poll_blocks_(due, now);
+  for (size_t i = 0; i < this->schedule_.size(); i++) {
+    if ((due & (1UL << i)) && static_cast<int32_t>(next_poll - this->schedule_[i].next_due) > 0)
+      next_poll = this->schedule_[i].next_due;
+  }
+  this->next_poll_ = next_poll;
+}
+
+// update_interval tick: polls every block that has no interval of its own. With other
+// units on the bus the poll is shifted to this unit's phase, so their bursts do not collide.
+void SaveVTRClimate::update() {
+  this->fieldbus_stats_.publish();
+  if (this->health_ == HEALTH_OFFLINE)
+    return;
+  const uint32_t now = millis();
+  const uint32_t delay = this->coordinator_ != nullptr
+                             ? this->coordinator_->phase_delay(this->bus_unit_, this->get_update_interval(), now)
+                             : 0;
+  if (delay == 0) {
+    this->poll_default_blocks_(now);
+    return;
+  }
+  this->update_pending_ = true;
+  this->update_due_ = now + delay;
+}
+
+void SaveVTRClimate::poll_default_blocks_(uint32_t now) {
+  uint32_t due = 0;
+  for (size_t i = 0; i < this->schedule_.size(); i++) {
+    if (this->schedule_[i].interval == 0)
+      due |= 1UL << i;
+  }
+  this->poll_blocks_(due, now);
+}
+
+// Add the given blocks to the read lane. Blocks joining a running cycle extend it;
+// blocks already pending are not queued twice.
+void SaveVTRClimate::poll_blocks_(uint32_t blocks_mask, uint32_t now) {
+  if (this->modbus_ == nullptr)
+    return;
+  if (!this->cycle_active_) {
+    this->fresh_registers_ = 0;
+    this->pending_blocks_ = 0;
+    this->cycle_blocks_ = 0;
+  }
+  blocks_mask &= ~(this->pending_blocks_ & ~this->readback_lane_);
+  if (blocks_mask == 0)
+    return;
+
+  for (size_t i = 0; i < this->schedule_.size(); i++) {
+    const uint32_t bit = 1UL << i;
+    if ((blocks_mask & bit) == 0)
+      continue;
+    uint32_t interval = this->block_interval_(i, now);
+    this->schedule_[i].next_due = now + (interval != 0 ? interval : this->get_update_interval());
+    // Still fresh in the cache (e.g. just read back after a write): nothing to fetch
+    if ((this->readback_lane_ & bit) == 0 && this->block_cached_(i, now)) {
+      blocks_mask &= ~bit;
+      continue;
+    }
+  }
+  if (blocks_mask == 0)
+    return;
+  this->read_lane_ |= blocks_mask;
+  this->pending_blocks_ |= blocks_mask;
+  this->cycle_blocks_ |= blocks_mask;
+  if (!this->cycle_active_) {
+    this->cycle_active_ = true;
+    this->cycle_deadline_ = now + this->poll_timeout_;
+    this->cycle_start_ = now;
+  }
+  this->dispatch_(now);
 }
 
 
@@ -1,22 +1,153 @@
 #pragma once
 
+#include <cmath>
+
 #include "esphome/core/component.h"
+#include "esphome/core/preferences.h"
 #include "esphome/components/climate/climate.h"
 #include "esphome/components/modbus_controller/modbus_controller.h"
 #include "esphome/components/sensor/sensor.h"
+#include "esphome/components/fieldbus/fieldbus_stats.h"
+#include "esphome/components/fieldbus/trace_buffer.h"
+#include "bus_coordinator.h"
+#include "register_cache.h"
+#include "register_plan.h"
+#include "save_vtr_binary_sensor.h"
+#include "window_aggregator.h"
 
 namespace esphome {
 namespace save_vtr {
 
+// Registers polled by the climate entity; used as PlannedRegister::id and RegisterCache slot.
+// Registers of other save_vtr platforms get cache slots from REGISTER_COUNT up.
+enum RegisterId : uint8_t {
+  REGISTER_SETPOINT = 0,
+  REGISTER_FAN_MODE,
+  REGISTER_OUTDOOR_TEMP,
+  REGISTER_SUPPLY_TEMP,
+  REGISTER_EXTRACT_TEMP,
+  REGISTER_HEAT_DEMAND,
+  REGISTER_SUPPLY_AIRFLOW,
+  REGISTER_EXTRACT_AIRFLOW,
+  REGISTER_RPM_SAF,
+  REGISTER_RPM_EAF,
+  REGISTER_COUNT,
+};
+
+class SaveVTRClimate;
+
+// Static description of a value decoded from a polled register
+struct RegisterDescriptor {
+  RegisterId id;
+  modbus_controller::ModbusRegisterType register_type;
+  uint16_t address;
+  bool is_signed;
+  float scale;                                       // applied to the raw register value
+  float SaveVTRClimate::*target;                     // decoded value, nullptr if decoded separately
+  sensor::Sensor *SaveVTRClimate::*sensor;           // published value, nullptr if none
+  const char *name;
+  const char *unit;
+};
+
+// Change-only publishing of one sensor
+struct PublishPolicy {
+  float deadband{0.0f};           // absolute change needed before publishing
+  float relative_deadband{0.0f};  // change needed relative to the last published value
+  uint32_t heartbeat{0};          // republish an unchanged value after this long, 0: never
+  float last_value{NAN};
+  uint32_t last_publish{0};
+  bool restored{false};  // last_value came from the snapshot; the first value read is always published
+};
+
+// Last decoded raw register values, kept in flash so sensors have a value right after boot
+struct RegisterSnapshot {
+  uint16_t valid;  // RegisterId bitmask
+  uint16_t raw[REGISTER_COUNT];
+};
+
+// Scheduling state of one planned read block
+struct BlockSchedule {
+  uint32_t interval;  // 0: polled by update() at update_interval
+  uint32_t next_due;
+  bool fan_related;   // polled at fan_boost_interval for a while after a fan mode change
+};
+
+// Link health, driven by consecutive unanswered commands
+enum UnitHealth : uint8_t {
+  HEALTH_ONLINE = 0,
+  HEALTH_DEGRADED,  // some commands timed out, still polling normally
+  HEALTH_OFFLINE,   // polling stopped; only a single probe register with backoff
+};
+
+// A user write waiting in the priority lane
+struct PendingWrite {
+  uint16_t address;
+  uint16_t value;
+  RegisterId readback;  // register read back right after the write
+  uint32_t ready_at;    // end of the debounce window
+  uint8_t attempts;     // times sent without an answer
+};
+
 class SaveVTRClimate : public climate::Climate, public PollingComponent {
  public:
   void update() override;
+  void loop() override;
   void control(const climate::ClimateCall &call) override;
   climate::ClimateTraits traits() override;
   void dump_config() override;
   void set_modbus(modbus_controller::ModbusController *modbus);
   void setup() override;
 
+  // Read planning: registers closer than max_read_gap are fetched in one multi-register read
+  void set_max_read_gap(uint16_t max_gap) { this->planner_.set_max_gap(max_gap); }
+  void set_max_registers_per_read(uint16_t max_count) { this->planner_.set_max_count(max_count); }
+  // Publish a poll cycle at the latest this long after it started, even if reads are outstanding
+  void set_poll_timeout(uint32_t poll_timeout) { this->poll_timeout_ = poll_timeout; }
+  // Poll a register that a configured sensor needs (the climate registers are always polled)
+  void add_polled_register(RegisterId id) { this->polled_registers_ |= 1 << id; }
+  // Serve a binary sensor from the register cache; its register joins the read plan
+  void register_binary_sensor(SaveVTRBinarySensor *sensor) { this->binary_sensors_.push_back(sensor); }
+  // Registers read less than this long ago are not polled again
+  void set_cache_ttl(uint32_t ttl) { this->cache_.set_ttl(ttl); }
+  const RegisterCache &get_cache() const { return this->cache_; }
+  // Latency per read block, errors and poll cycle times
+  fieldbus::FieldbusStats &get_fieldbus_stats() { return this->fieldbus_stats_; }
+  // With a trace buffer, register reads are recorded as binary events instead of logged
+  fieldbus::TraceBuffer &get_trace() { return this->trace_; }
+  void dump_trace();
+  // Poll a register on its own interval instead of update_interval; the shortest request wins
+  void set_poll_interval(RegisterId id, uint32_t interval);
+  void set_fan_boost_interval(uint32_t interval) { this->fan_boost_interval_ = interval; }
+  void set_fan_boost_duration(uint32_t duration) { this->fan_boost_duration_ = duration; }
+  // Give up waiting for an answer after this long and move on to the next command
+  void set_command_timeout(uint32_t timeout) { this->command_timeout_ = timeout; }
+  // Hold writes this long so a burst of control() calls only sends the last value
+  void set_write_debounce(uint32_t debounce) { this->write_debounce_ = debounce; }
+  // Merge writes to adjacent registers into one function 16 frame
+  void set_write_multiple(bool write_multiple) { this->write_multiple_ = write_multiple; }
+  // Consider the unit offline after this many unanswered commands in a row
+  void set_offline_after(uint8_t offline_after) { this->offline_after_ = offline_after; }
+  // While offline, probe at this interval, doubling after every failed probe up to max_probe_interval
+  void set_probe_interval(uint32_t interval) { this->probe_interval_ = interval; }
+  void set_max_probe_interval(uint32_t interval) { this->max_probe_interval_ = interval; }
+  UnitHealth get_health() const { return this->health_; }
+  // Share the RS-485 segment with the other save_vtr units on the same modbus
+  void set_bus_coordinator(BusCoordinator *coordinator, uint8_t budget) {
+    this->coordinator_ = coordinator;
+    this->bus_unit_ = coordinator->add_unit(budget);
+  }
+  void set_bus_utilization_sensor(sensor::Sensor *sensor) { this->bus_utilization_sensor_ = sensor; }
+  // On while any published value was restored from flash or missed its poll deadline
+  void set_stale_sensor(binary_sensor::BinarySensor *sensor) { this->stale_sensor_ = sensor; }
+  // Save decoded values to flash at most this often (0: never) and publish them as stale on boot
+  void set_snapshot_interval(uint32_t interval) { this->snapshot_interval_ = interval; }
+  // Publish a sensor only when it moves past max(deadband, relative_deadband * |last|) or heartbeat expires
+  void set_publish_policy(sensor::Sensor *sensor, float deadband, float relative_deadband, uint32_t heartbeat);
+  // Feed every fresh value of a sensor into a windowed min/max/mean aggregator
+  void add_aggregator(sensor::Sensor *source, WindowAggregator *aggregator) {
+    this->aggregators_.push_back({source, aggregator});
+  }
+
   // Sensor setter methods
 
   void set_saf_percent_sensor(esphome::sensor::Sensor *sensor) { saf_percent_sensor_ = sensor; }
@@ -29,9 +160,122 @@ class SaveVTRClimate : public climate::Climate, public PollingComponent {
   void set_extract_air_temp_sensor(esphome::sensor::Sensor *sensor) { extract_air_temp_sensor_ = sensor; }
   void set_rpm_saf_sensor(esphome::sensor::Sensor *sensor) { rpm_saf_sensor_ = sensor; }
   void set_rpm_eaf_sensor(esphome::sensor::Sensor *sensor) { rpm_eaf_sensor_ = sensor; }
+  void set_heat_recovery_efficiency_sensor(esphome::sensor::Sensor *sensor) {
+    heat_recovery_efficiency_sensor_ = sensor;
+  }
 
  protected:
+  static constexpr uint8_t DESCRIPTOR_COUNT = 12;
+  static const RegisterDescriptor REGISTERS[DESCRIPTOR_COUNT];
+  // Registers the climate entity needs for target/current temperature and fan mode
+  static constexpr uint16_t CLIMATE_REGISTERS =
+      (1 << REGISTER_SETPOINT) | (1 << REGISTER_SUPPLY_TEMP) | (1 << REGISTER_FAN_MODE);
+  static constexpr uint8_t MAX_PENDING_WRITES = 4;
+  static constexpr uint8_t MAX_WRITE_ATTEMPTS = 3;
+  static constexpr uint8_t NO_COMMAND = 0xFF;
+  static constexpr uint8_t WRITE_COMMAND = 0xFE;
+  static constexpr uint8_t PROBE_COMMAND = 0xFD;
+
+  void on_block_data_(size_t block_index, const std::vector<uint8_t> &data);
+  void decode_register_(uint8_t id, uint16_t raw);
+  // source prefixes the debug log line ("Read", "Restored"); nullptr logs nothing
+  void apply_register_(uint8_t id, uint16_t raw, const char *source);
+  void restore_snapshot_();
+  void save_snapshot_(uint32_t now);
+  void finish_cycle_(bool timed_out);
+  void publish_stale_();
+  void poll_blocks_(uint32_t blocks, uint32_t now);
+  uint32_t block_interval_(size_t block_index, uint32_t now) const;
+  bool block_cached_(size_t block_index, uint32_t now) const;
+  void start_fan_boost_();
+  void queue_write_(uint16_t address, uint16_t value, RegisterId readback);
+  void dispatch_(uint32_t now);
+  void remove_writes_(uint8_t mask);
+  void retry_writes_(uint32_t now);
+  bool dispatch_write_(uint32_t now);
+  uint8_t first_ready_write_(uint32_t now) const;
+  void end_command_();
+  void poll_default_blocks_(uint32_t now);
+  void on_write_done_(uint16_t readback);
+  void on_command_timeout_(uint32_t now);
+  void on_answer_();
+  void go_offline_(uint32_t now);
+  void go_online_();
+  void on_sample_(PublishPolicy &policy, sensor::Sensor *sensor, float value, uint32_t now);
+  void publish_sensor_(PublishPolicy &policy, sensor::Sensor *sensor, float value, uint32_t now);
+  void check_heartbeats_(uint32_t now);
+  void republish_(PublishPolicy &policy, sensor::Sensor *sensor, uint32_t now);
+  void update_derived_(uint32_t now);
+  void publish_climate_();
+
   modbus_controller::ModbusController *modbus_{nullptr};
+  RegisterPlanner planner_;
+  RegisterCache cache_;
+  std::vector<SaveVTRBinarySensor *> binary_sensors_;
+  uint16_t polled_registers_{CLIMATE_REGISTERS};  // RegisterId bitmask, set from codegen; see CLIMATE_REGISTERS
+  std::vector<modbus_controller::ModbusCommandItem> read_commands_;  // one per planned block, built in setup()
+
+  // Poll cycle tracking: one bit per outstanding block read and per register decoded this cycle
+  uint32_t poll_timeout_{10000};
+  uint32_t pending_blocks_{0};
+  uint32_t fresh_registers_{0};  // one bit per cache slot
+  uint32_t stale_registers_{0};  // restored or missed a cycle deadline, until read again
+  uint32_t cycle_blocks_{0};
+  uint32_t cycle_start_{0};
+  uint32_t cycle_deadline_{0};
+  bool cycle_active_{false};
+
+  // Tiered polling: per-register intervals and the resulting per-block deadlines
+  uint32_t poll_intervals_[REGISTER_COUNT]{};
+  std::vector<BlockSchedule> schedule_;
+  uint32_t next_poll_{0};
+  uint32_t fan_boost_interval_{5000};
+  uint32_t fan_boost_duration_{60000};
+  uint32_t fan_boost_until_{0};
+
+  // Dispatch lanes: writes first, then read-backs, then regular poll reads
+  PendingWrite writes_[MAX_PENDING_WRITES];
+  uint8_t write_count_{0};
+  PendingWrite sent_writes_[MAX_PENDING_WRITES];  // writes of the frame in flight
+  uint8_t sent_write_count_{0};
+  uint32_t write_debounce_{500};
+  bool write_multiple_{true};
+  uint32_t readback_lane_{0};
+  uint32_t read_lane_{0};
+  uint8_t block_of_[RegisterCache::MAX_REGISTERS];  // planned block holding each register, NO_COMMAND if not polled
+  std::vector<uint8_t> dispatch_order_;  // block indices, most important registers first
+  uint8_t in_flight_{NO_COMMAND};  // block index, WRITE_COMMAND or NO_COMMAND
+  uint32_t in_flight_since_{0};
+  uint32_t in_flight_started_us_{0};  // micros() when the command went out, for latency stats
+  uint32_t command_timeout_{2000};
+
+  // Shared bus: turn taking and poll phase across the units on the same modbus
+  BusCoordinator *coordinator_{nullptr};
+  uint8_t bus_unit_{0};
+  bool update_pending_{false};
+  uint32_t update_due_{0};
+  sensor::Sensor *bus_utilization_sensor_{nullptr};
+
+  // Circuit breaker for an unresponsive unit
+  UnitHealth health_{HEALTH_ONLINE};
+  uint8_t offline_after_{3};
+  uint8_t consecutive_timeouts_{0};
+  uint32_t probe_interval_{10000};
+  uint32_t max_probe_interval_{300000};
+  uint32_t probe_backoff_{0};
+  uint32_t next_probe_{0};
+  modbus_controller::ModbusCommandItem probe_command_;
+
+  // Warm start: last decoded values in flash, written at most every snapshot_interval
+  ESPPreferenceObject snapshot_pref_;
+  RegisterSnapshot snapshot_{};
+  uint32_t snapshot_interval_{900000};
+  uint32_t last_snapshot_{0};
+  bool snapshot_dirty_{false};
+
+  fieldbus::FieldbusStats fieldbus_stats_;
+  fieldbus::TraceBuffer trace_;
+
   float heat_demand_percent_{0.0f};     // Heat demand percentage (0-100%)
   float saf_percent_{0.0f};             // Supply Air Flow (same as volume)
   float saf_volume_{0.0f};              // Supply Air Flow volume (m³/h)
@@ -42,6 +286,19 @@ class SaveVTRClimate : public climate::Climate, public PollingComponent {
   float extract_air_temp_{0.0f};        // Extract air temperature (°C, scaled /10)
   float rpm_saf_{0.0f};                 // Supply air fan RPM
   float rpm_eaf_{0.0f};                 // Extract air fan RPM
+  uint16_t fan_mode_raw_{0xFFFF};       // Last fan mode register value
+  float heat_recovery_efficiency_{NAN}; // Derived from outdoor, supply and extract temperature (%)
+
+  // Publishing: per-descriptor sensor policies and the climate fields as last published
+  PublishPolicy publish_policies_[DESCRIPTOR_COUNT];
+  PublishPolicy heat_recovery_policy_;
+  uint32_t last_heartbeat_check_{0};
+  std::vector<std::pair<sensor::Sensor *, WindowAggregator *>> aggregators_;
+  float published_current_temperature_{NAN};
+  float published_target_temperature_{NAN};
+  climate::ClimateMode published_mode_{climate::CLIMATE_MODE_OFF};
+  uint16_t published_fan_mode_raw_{0xFFFF};
+  bool climate_published_{false};
 
   // Sensor pointers
   esphome::sensor::Sensor *saf_percent_sensor_{nullptr};
@@ -54,6 +311,8 @@ class SaveVTRClimate : public climate::Climate, public PollingComponent {
   esphome::sensor::Sensor *extract_air_temp_sensor_{nullptr};
   esphome::sensor::Sensor *rpm_saf_sensor_{nullptr};
   esphome::sensor::Sensor *rpm_eaf_sensor_{nullptr};
+  esphome::sensor::Sensor *heat_recovery_efficiency_sensor_{nullptr};
+  binary_sensor::BinarySensor *stale_sensor_{nullptr};
 };
 
 }  // namespace save_vtr
@@ -0,0 +1,20 @@
+#include "save_vtr_binary_sensor.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace save_vtr {
+
+static const char *const TAG = "save_vtr.binary_sensor";
+
+void SaveVTRBinarySensor::on_register_value(uint16_t value) {
+  this->publish_state((value & this->bitmask_) != 0);
+}
+
+void SaveVTRBinarySensor::dump_config() {
+  LOG_BINARY_SENSOR("  ", "Binary Sensor", this);
+  ESP_LOGCONFIG(TAG, "    Register: %u (type %u), bitmask 0x%04X", this->address_,
+                static_cast<uint8_t>(this->register_type_), this->bitmask_);
+}
+
+}  // namespace save_vtr
+}  // namespace esphome
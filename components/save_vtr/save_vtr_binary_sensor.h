@@ -0,0 +1,36 @@
+#pragma once
+
+#include "esphome/components/binary_sensor/binary_sensor.h"
+#include "esphome/components/modbus_controller/modbus_controller.h"
+
+namespace esphome {
+namespace save_vtr {
+
+// Binary sensor on a register bit of the unit. It never talks to the bus itself: the
+// SaveVTRClimate it belongs to polls the register and hands over the cached value.
+class SaveVTRBinarySensor : public binary_sensor::BinarySensor {
+ public:
+  void set_register(modbus_controller::ModbusRegisterType register_type, uint16_t address) {
+    this->register_type_ = register_type;
+    this->address_ = address;
+  }
+  void set_bitmask(uint16_t bitmask) { this->bitmask_ = bitmask; }
+
+  modbus_controller::ModbusRegisterType get_register_type() const { return this->register_type_; }
+  uint16_t get_address() const { return this->address_; }
+  void set_cache_slot(uint8_t slot) { this->cache_slot_ = slot; }
+  uint8_t get_cache_slot() const { return this->cache_slot_; }
+
+  // Called with the cached register value each time it was refreshed from the bus
+  void on_register_value(uint16_t value);
+  void dump_config();
+
+ protected:
+  modbus_controller::ModbusRegisterType register_type_{modbus_controller::ModbusRegisterType::READ};
+  uint16_t address_{0};
+  uint16_t bitmask_{0xFFFF};
+  uint8_t cache_slot_{0xFF};
+};
+
+}  // namespace save_vtr
+}  // namespace esphome
@@ -2,7 +2,8 @@ import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import sensor
 from esphome.const import CONF_ID, CONF_UNIT_OF_MEASUREMENT, CONF_ICON, CONF_ACCURACY_DECIMALS
-from . import save_vtr_ns, SaveVTRClimate
+from esphome.components.fieldbus import HISTORY_SCHEMA, STATS_SENSOR_SCHEMA, register_history, register_stats_sensors
+from . import save_vtr_ns, SaveVTRClimate, RegisterId
 import esphome.components.sensor as sensor_core
 
 
@@ -18,6 +19,19 @@ CONF_SUPPLY_AIR_TEMP = "supply_air_temp"
 CONF_EXTRACT_AIR_TEMP = "extract_air_temp"
 CONF_RPM_SAF = "rpm_saf"
 CONF_RPM_EAF = "rpm_eaf"
+CONF_POLL_INTERVAL = "poll_interval"
+CONF_DEADBAND = "deadband"
+CONF_RELATIVE_DEADBAND = "relative_deadband"
+CONF_HEARTBEAT = "heartbeat"
+CONF_HEAT_RECOVERY_EFFICIENCY = "heat_recovery_efficiency"
+CONF_AGGREGATE = "aggregate"
+CONF_WINDOW = "window"
+CONF_MIN = "min"
+CONF_MAX = "max"
+CONF_MEAN = "mean"
+CONF_BUS_UTILIZATION = "bus_utilization"
+
+WindowAggregator = save_vtr_ns.class_("WindowAggregator")
 
 SENSORS = [
     (CONF_SAF_PERCENT, "%", "mdi:fan", 0),
@@ -30,8 +44,41 @@ SENSORS = [
     (CONF_EXTRACT_AIR_TEMP, "°C", "mdi:thermometer", 1),
     (CONF_RPM_SAF, "RPM", "mdi:fan", 0),
     (CONF_RPM_EAF, "RPM", "mdi:fan", 0),
+    (CONF_HEAT_RECOVERY_EFFICIENCY, "%", "mdi:heat-wave", 0),
 ]
 
+# Modbus registers each sensor is decoded or derived from
+SENSOR_REGISTERS = {
+    CONF_SAF_PERCENT: [RegisterId.REGISTER_SUPPLY_AIRFLOW],
+    CONF_SAF_VOLUME: [RegisterId.REGISTER_SUPPLY_AIRFLOW],
+    CONF_EAF_PERCENT: [RegisterId.REGISTER_EXTRACT_AIRFLOW],
+    CONF_EAF_VOLUME: [RegisterId.REGISTER_EXTRACT_AIRFLOW],
+    CONF_HEAT_DEMAND: [RegisterId.REGISTER_HEAT_DEMAND],
+    CONF_OUTDOOR_AIR_TEMP: [RegisterId.REGISTER_OUTDOOR_TEMP],
+    CONF_SUPPLY_AIR_TEMP: [RegisterId.REGISTER_SUPPLY_TEMP],
+    CONF_EXTRACT_AIR_TEMP: [RegisterId.REGISTER_EXTRACT_TEMP],
+    CONF_RPM_SAF: [RegisterId.REGISTER_RPM_SAF],
+    CONF_RPM_EAF: [RegisterId.REGISTER_RPM_EAF],
+    CONF_HEAT_RECOVERY_EFFICIENCY: [
+        RegisterId.REGISTER_OUTDOOR_TEMP,
+        RegisterId.REGISTER_SUPPLY_TEMP,
+        RegisterId.REGISTER_EXTRACT_TEMP,
+    ],
+}
+
+
+def aggregate_schema(unit, icon, decimals):
+    # Min/max/mean over tumbling windows, published once per window
+    stat = sensor.sensor_schema(unit_of_measurement=unit, icon=icon, accuracy_decimals=decimals)
+    return cv.Schema({
+        cv.GenerateID(): cv.declare_id(WindowAggregator),
+        cv.Optional(CONF_WINDOW, default="60s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_MIN): stat,
+        cv.Optional(CONF_MAX): stat,
+        cv.Optional(CONF_MEAN): stat,
+    })
+
+
 CONFIG_SCHEMA = cv.Schema({
     cv.GenerateID(): cv.use_id(SaveVTRClimate),
     **{
@@ -39,15 +86,66 @@ CONFIG_SCHEMA = cv.Schema({
             unit_of_measurement=unit,
             icon=icon,
             accuracy_decimals=decimals,
-        )
+        ).extend({
+            # Poll the underlying register on its own interval instead of the climate's update_interval
+            cv.Optional(CONF_POLL_INTERVAL): cv.positive_time_period_milliseconds,
+            # Only publish when the value moves further than the deadband (absolute, or relative
+            # to the last published value), or when nothing was published for heartbeat
+            cv.Optional(CONF_DEADBAND, default=0.0): cv.float_range(min=0.0),
+            cv.Optional(CONF_RELATIVE_DEADBAND, default="0%"): cv.percentage,
+            cv.Optional(CONF_HEARTBEAT, default="0s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_AGGREGATE): aggregate_schema(unit, icon, decimals),
+        })
         for name, unit, icon, decimals in SENSORS
     },
+    # Share of time a command of any save_vtr unit on this bus was waiting for an answer
+    cv.Optional(CONF_BUS_UTILIZATION): sensor.sensor_schema(
+        unit_of_measurement="%",
+        icon="mdi:gauge",
+        accuracy_decimals=1,
+    ),
+    # Modbus transaction latency, errors, probe retries and poll cycle time of this unit
+    **STATS_SENSOR_SCHEMA,
+    # Backfill these sensors (and their aggregates) after an API outage
+    **HISTORY_SCHEMA,
 })
 
 async def to_code(config):
     paren = await cg.get_variable(config[CONF_ID])
+    # Only the registers behind configured sensors are polled
+    registers = {}
+    for name, _, _, _ in SENSORS:
+        if name in config:
+            for register in SENSOR_REGISTERS[name]:
+                registers[str(register)] = register
+    for register in registers.values():
+        cg.add(paren.add_polled_register(register))
+
+    history = []
     for name, _, _, _ in SENSORS:
         if name in config:
             sens = await sensor.new_sensor(config[name])
+            history.append(sens)
             cg.add(getattr(paren, f"set_{name}_sensor")(sens))
+            cg.add(paren.set_publish_policy(
+                sens, config[name][CONF_DEADBAND], config[name][CONF_RELATIVE_DEADBAND], config[name][CONF_HEARTBEAT]))
+            if CONF_POLL_INTERVAL in config[name]:
+                for register in SENSOR_REGISTERS[name]:
+                    cg.add(paren.set_poll_interval(register, config[name][CONF_POLL_INTERVAL]))
+            if CONF_AGGREGATE in config[name]:
+                agg_config = config[name][CONF_AGGREGATE]
+                agg = cg.new_Pvariable(agg_config[CONF_ID])
+                cg.add(agg.set_window(agg_config[CONF_WINDOW]))
+                for stat in (CONF_MIN, CONF_MAX, CONF_MEAN):
+                    if stat in agg_config:
+                        stat_sens = await sensor.new_sensor(agg_config[stat])
+                        history.append(stat_sens)
+                        cg.add(getattr(agg, f"set_{stat}_sensor")(stat_sens))
+                cg.add(paren.add_aggregator(sens, agg))
+
+    if CONF_BUS_UTILIZATION in config:
+        sens = await sensor.new_sensor(config[CONF_BUS_UTILIZATION])
+        cg.add(paren.set_bus_utilization_sensor(sens))
 
+    await register_stats_sensors(paren.get_fieldbus_stats(), config)
+    await register_history(history, config)
@@ -0,0 +1,71 @@
+#include "window_aggregator.h"
+#include "esphome/core/log.h"
+#include <cinttypes>
+#include <cmath>
+
+namespace esphome {
+namespace save_vtr {
+
+static const char *const TAG = "save_vtr.aggregate";
+
+void WindowAggregator::add_sample(float value, uint32_t now) {
+  if (std::isnan(value))
+    return;
+  this->check_window(now);
+  if (this->count_ == 0) {
+    if (!this->open_) {
+      this->open_ = true;
+      this->window_start_ = now;
+    }
+    this->min_ = value;
+    this->max_ = value;
+    this->sum_ = 0.0f;
+  }
+  this->count_++;
+  this->sum_ += value;
+  if (value < this->min_)
+    this->min_ = value;
+  if (value > this->max_)
+    this->max_ = value;
+}
+
+// A window with samples is published and the next one follows on straight away. A window
+// without any (unit offline, only NAN samples) publishes NAN once; the aggregator then
+// waits for the next sample to open a new window.
+void WindowAggregator::check_window(uint32_t now) {
+  if (!this->open_ || now - this->window_start_ < this->window_)
+    return;
+  this->publish_();
+  if (this->count_ == 0) {
+    this->open_ = false;
+    return;
+  }
+  this->count_ = 0;
+  this->window_start_ += this->window_;
+  if (now - this->window_start_ >= this->window_)
+    this->window_start_ = now;
+}
+
+void WindowAggregator::publish_() {
+  const bool empty = this->count_ == 0;
+  const float min = empty ? NAN : this->min_;
+  const float max = empty ? NAN : this->max_;
+  const float mean = empty ? NAN : this->sum_ / this->count_;
+  ESP_LOGV(TAG, "Window of %" PRIu32 " samples: min %.2f, max %.2f, mean %.2f", this->count_, min, max, mean);
+  if (this->min_sensor_ != nullptr)
+    this->min_sensor_->publish_state(min);
+  if (this->max_sensor_ != nullptr)
+    this->max_sensor_->publish_state(max);
+  if (this->mean_sensor_ != nullptr)
+    this->mean_sensor_->publish_state(mean);
+}
+
+void WindowAggregator::dump_config(const char *name) {
+  ESP_LOGCONFIG(TAG, "  Aggregating %s over %" PRIu32 "ms windows", name, this->window_);
+  LOG_SENSOR("    ", "Min", this->min_sensor_);
+  LOG_SENSOR("    ", "Max", this->max_sensor_);
+  LOG_SENSOR("    ", "Mean", this->mean_sensor_);
+}
+
+}  // namespace save_vtr
+}  // namespace esphome
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esphome/components/sensor/sensor.h"
+
+namespace esphome {
+namespace save_vtr {
+
+// Min/max/mean of a sensor over tumbling windows. The running statistics are updated in
+// O(1) per sample and need no sample storage, so a register can be sampled much faster
+// than the aggregates are published.
+class WindowAggregator {
+ public:
+  void set_window(uint32_t window) { this->window_ = window; }
+  void set_min_sensor(sensor::Sensor *sensor) { this->min_sensor_ = sensor; }
+  void set_max_sensor(sensor::Sensor *sensor) { this->max_sensor_ = sensor; }
+  void set_mean_sensor(sensor::Sensor *sensor) { this->mean_sensor_ = sensor; }
+
+  // Add a sample to the running window
+  void add_sample(float value, uint32_t now);
+  // Publish and restart the window once it has run for `window` ms; called on every
+  // sample and from loop(), so the last window is published even when samples stop
+  void check_window(uint32_t now);
+  void dump_config(const char *name);
+
+ protected:
+  void publish_();
+
+  uint32_t window_{60000};
+  uint32_t window_start_{0};
+  uint32_t count_{0};
+  bool open_{false};  // a window is running; false until the first sample
+  float sum_{0.0f};
+  float min_{0.0f};
+  float max_{0.0f};
+  sensor::Sensor *min_sensor_{nullptr};
+  sensor::Sensor *max_sensor_{nullptr};
+  sensor::Sensor *mean_sensor_{nullptr};
+};
+
+}  // namespace save_vtr
+}  // namespace esphome
@@ -0,0 +1,130 @@
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "check.h"
+#include "esphome/components/fieldbus/history_buffer.h"
+
+using namespace esphome;
+using namespace esphome::host;
+using fieldbus::HistoryBuffer;
+
+struct Sample {
+  uint32_t time;
+  float value;
+};
+
+// Reads drain() output back the way a Home Assistant automation would: the first age counts
+// back from `now`, later times and values after the first real one are deltas, in 0.1 s and
+// 10^-decimals units; an empty value is NAN
+static std::vector<Sample> decode(const char *text, uint32_t now, int8_t decimals) {
+  std::vector<Sample> samples;
+  const float scale = std::pow(10.0f, decimals);
+  uint32_t time = 0;
+  int32_t value = 0;
+  bool have_value = false;
+  const char *p = text;
+  while (*p != '\0') {
+    char *end;
+    const uint32_t ticks = std::strtoul(p, &end, 10);
+    time = samples.empty() ? now - ticks * 100 : time + ticks * 100;
+    p = end + 1;  // ':'
+    float decoded = NAN;
+    if (*p != ',' && *p != '\0') {
+      const int32_t q = std::strtol(p, &end, 10);
+      value = have_value ? value + q : q;
+      have_value = true;
+      decoded = value / scale;
+      p = end;
+    }
+    samples.push_back(Sample{time, decoded});
+    if (*p == ',')
+      p++;
+  }
+  return samples;
+}
+
+static bool same(float actual, float expected) {
+  return std::isnan(expected) ? std::isnan(actual) : std::fabs(actual - expected) < 0.001f;
+}
+
+static void check_samples(const std::vector<Sample> &actual, const std::vector<Sample> &expected) {
+  CHECK_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < actual.size() && i < expected.size(); i++) {
+    CHECK_EQ(actual[i].time, expected[i].time);
+    if (!same(actual[i].value, expected[i].value)) {
+      std::fprintf(stderr, "    sample %zu: %g, expected %g\n", i, actual[i].value, expected[i].value);
+      CHECK(same(actual[i].value, expected[i].value));
+    }
+  }
+}
+
+// Values, gaps and NAN survive the encoding, including varints of several bytes for large
+// steps and long gaps and negative deltas through zigzag
+TEST_CASE(history_round_trip) {
+  uint8_t storage[128];
+  HistoryBuffer buffer;
+  buffer.init(storage, sizeof(storage), 1);
+  const std::vector<Sample> recorded = {
+      {1000, 20.0f},   {2000, 20.1f},     {3000, NAN},        {4000, 19.8f},
+      {5000, -250.5f}, {3605000, 1000.0f}, {3605100, -1000.0f}, {3606000, 0.0f},
+  };
+  for (const auto &sample : recorded)
+    buffer.record(sample.time, sample.value);
+  CHECK_EQ(buffer.dropped(), 0u);
+
+  char out[256];
+  const uint32_t now = 3700000;
+  CHECK_EQ(buffer.drain(now, out, sizeof(out)), recorded.size());
+  CHECK(buffer.empty());
+  check_samples(decode(out, now, 1), recorded);
+}
+
+// A full buffer drops the oldest samples; what is left still decodes from an absolute start
+TEST_CASE(history_overflow_drops_oldest) {
+  uint8_t storage[16];
+  HistoryBuffer buffer;
+  buffer.init(storage, sizeof(storage), 0);
+  std::vector<Sample> recorded;
+  for (uint32_t i = 0; i < 20; i++) {
+    recorded.push_back(Sample{10000 + i * 1000, float(100 + i)});
+    buffer.record(recorded.back().time, recorded.back().value);
+  }
+  // Two bytes per sample: one second and one step up
+  CHECK_EQ(buffer.used(), 16u);
+  CHECK_EQ(buffer.dropped(), 12u);
+
+  char out[256];
+  const uint32_t now = 40000;
+  CHECK_EQ(buffer.drain(now, out, sizeof(out)), 8u);
+  check_samples(decode(out, now, 0), std::vector<Sample>(recorded.end() - 8, recorded.end()));
+}
+
+// A drain that fills its output stops there; every batch decodes on its own
+TEST_CASE(history_drains_in_batches) {
+  uint8_t storage[256];
+  HistoryBuffer buffer;
+  buffer.init(storage, sizeof(storage), 2);
+  std::vector<Sample> recorded;
+  for (uint32_t i = 0; i < 40; i++) {
+    recorded.push_back(Sample{i * 500, i % 7 == 3 ? NAN : 4.0f + i * 0.25f});
+    buffer.record(recorded.back().time, recorded.back().value);
+  }
+
+  std::vector<Sample> drained;
+  char out[48];
+  const uint32_t now = 60000;
+  uint32_t batches = 0;
+  while (!buffer.empty() && batches < 100) {
+    const uint16_t count = buffer.drain(now, out, sizeof(out));
+    CHECK(count != 0);
+    if (count == 0)
+      break;
+    const auto batch = decode(out, now, 2);
+    CHECK_EQ(batch.size(), count);
+    drained.insert(drained.end(), batch.begin(), batch.end());
+    batches++;
+  }
+  CHECK(batches > 1);
+  check_samples(drained, recorded);
+}
@@ -0,0 +1,36 @@
+#include "alloc_counter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace esphome {
+namespace host {
+
+static uint64_t allocations = 0;
+static uint64_t external_allocations = 0;
+static uint32_t external_depth = 0;
+
+uint64_t allocation_count() { return allocations; }
+uint64_t external_allocation_count() { return external_allocations; }
+
+ExternalAllocationScope::ExternalAllocationScope() { external_depth++; }
+ExternalAllocationScope::~ExternalAllocationScope() { external_depth--; }
+
+}  // namespace host
+}  // namespace esphome
+
+// new[] and the nothrow forms end up here in libstdc++
+void *operator new(std::size_t size) {
+  if (esphome::host::external_depth != 0) {
+    esphome::host::external_allocations++;
+  } else {
+    esphome::host::allocations++;
+  }
+  void *ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+namespace host {
+
+// Every operator new on the host is counted. Allocations made while an
+// ExternalAllocationScope is alive belong to the framework stand-ins (the modbus
+// controller copying a queued command, the logger, the preference store) and are counted
+// apart, so a test can tell them from the allocations of the component under test.
+uint64_t allocation_count();
+uint64_t external_allocation_count();
+
+class ExternalAllocationScope {
+ public:
+  ExternalAllocationScope();
+  ~ExternalAllocationScope();
+  ExternalAllocationScope(const ExternalAllocationScope &) = delete;
+  ExternalAllocationScope &operator=(const ExternalAllocationScope &) = delete;
+};
+
+}  // namespace host
+}  // namespace esphome
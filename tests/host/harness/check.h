@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+namespace esphome {
+namespace host {
+
+// Just enough of a test framework: TEST_CASE registers a function, CHECK records a failure
+// and carries on, test_main.cpp runs every case (or those named on the command line)
+struct TestCase {
+  const char *name;
+  void (*func)();
+};
+
+std::vector<TestCase> &test_cases();
+void record_failure(const char *file, int line, const char *expression);
+
+struct TestRegistrar {
+  TestRegistrar(const char *name, void (*func)()) { test_cases().push_back({name, func}); }
+};
+
+}  // namespace host
+}  // namespace esphome
+
+#define TEST_CASE(name) \
+  static void name(); \
+  static ::esphome::host::TestRegistrar name##_registrar(#name, name); \
+  static void name()
+
+#define CHECK(expression) \
+  do { \
+    if (!(expression)) \
+      ::esphome::host::record_failure(__FILE__, __LINE__, #expression); \
+  } while (false)
+
+#define CHECK_EQ(actual, expected) \
+  do { \
+    const auto actual_value = (actual); \
+    const auto expected_value = (expected); \
+    if (!(actual_value == expected_value)) { \
+      std::fprintf(stderr, "    actual: %g, expected: %g\n", static_cast<double>(actual_value), \
+                   static_cast<double>(expected_value)); \
+      ::esphome::host::record_failure(__FILE__, __LINE__, #actual " == " #expected); \
+    } \
+  } while (false)
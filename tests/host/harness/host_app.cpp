@@ -0,0 +1,89 @@
+#include "host_app.h"
+
+#include <algorithm>
+
+namespace esphome {
+namespace host {
+
+void HostApp::register_component(Component *component) {
+  this->entries_.push_back(Entry{component, dynamic_cast<PollingComponent *>(component), 0, 0, 0});
+}
+
+void HostApp::setup() {
+  std::stable_sort(this->entries_.begin(), this->entries_.end(), [](const Entry &a, const Entry &b) {
+    return a.component->get_setup_priority() > b.component->get_setup_priority();
+  });
+  for (auto &entry : this->entries_) {
+    this->call_(entry, CALL_SETUP);
+    if (entry.poller != nullptr)
+      entry.next_update = millis() + entry.poller->get_update_interval();
+  }
+}
+
+void HostApp::run_for(uint32_t duration, uint32_t tick_us) {
+  const uint64_t end = time_us() + uint64_t(duration) * 1000;
+  while (time_us() < end)
+    this->tick_(tick_us);
+}
+
+bool HostApp::run_until(const std::function<bool()> &condition, uint32_t timeout, uint32_t tick_us) {
+  const uint64_t end = time_us() + uint64_t(timeout) * 1000;
+  while (!condition()) {
+    if (time_us() >= end)
+      return false;
+    this->tick_(tick_us);
+  }
+  return true;
+}
+
+uint32_t HostApp::max_blocking_us(const Component *component) const {
+  const Entry *entry = this->find_(component);
+  return entry != nullptr ? entry->max_blocking_us : 0;
+}
+
+uint64_t HostApp::total_blocking_us(const Component *component) const {
+  const Entry *entry = this->find_(component);
+  return entry != nullptr ? entry->total_blocking_us : 0;
+}
+
+void HostApp::tick_(uint32_t tick_us) {
+  for (auto &entry : this->entries_) {
+    if (entry.component->is_failed())
+      continue;
+    this->call_(entry, CALL_LOOP);
+    if (entry.poller != nullptr && static_cast<int32_t>(millis() - entry.next_update) >= 0) {
+      entry.next_update += entry.poller->get_update_interval();
+      this->call_(entry, CALL_UPDATE);
+    }
+  }
+  advance_time_us(tick_us);
+}
+
+void HostApp::call_(Entry &entry, Call call) {
+  const uint64_t start = time_us();
+  switch (call) {
+    case CALL_SETUP:
+      entry.component->setup();
+      break;
+    case CALL_LOOP:
+      entry.component->loop();
+      break;
+    case CALL_UPDATE:
+      entry.poller->update();
+      break;
+  }
+  const uint64_t blocked = time_us() - start;
+  entry.max_blocking_us = std::max<uint32_t>(entry.max_blocking_us, blocked);
+  entry.total_blocking_us += blocked;
+}
+
+const HostApp::Entry *HostApp::find_(const Component *component) const {
+  for (const auto &entry : this->entries_) {
+    if (entry.component == component)
+      return &entry;
+  }
+  return nullptr;
+}
+
+}  // namespace host
+}  // namespace esphome
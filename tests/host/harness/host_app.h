@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace host {
+
+// Simulated clock behind millis()/micros(); delay() advances it as well
+uint64_t time_us();
+void advance_time_us(uint64_t us);
+// Forget everything saved to preferences, as after erasing the flash
+void clear_preferences();
+// Preference writes, i.e. flash writes, since the last clear_preferences()
+uint32_t preference_saves();
+
+// Stand-in for App: sets components up by setup priority, then runs loop() on every tick and
+// update() every update_interval against the simulated clock. The simulated time a component
+// spends inside loop() or update() (its delay() calls) is how long it blocked the main loop.
+class HostApp {
+ public:
+  void register_component(Component *component);
+  void setup();
+  // Run ticks until `duration` ms of simulated time have passed
+  void run_for(uint32_t duration, uint32_t tick_us = 1000);
+  // Run ticks until `condition` holds or `timeout` ms passed; returns whether it held
+  bool run_until(const std::function<bool()> &condition, uint32_t timeout, uint32_t tick_us = 1000);
+
+  // Longest single loop()/update() call of a component, in us
+  uint32_t max_blocking_us(const Component *component) const;
+  uint64_t total_blocking_us(const Component *component) const;
+
+ protected:
+  struct Entry {
+    Component *component;
+    PollingComponent *poller;  // nullptr if not a PollingComponent
+    uint32_t next_update;
+    uint32_t max_blocking_us;
+    uint64_t total_blocking_us;
+  };
+
+  enum Call : uint8_t { CALL_SETUP, CALL_LOOP, CALL_UPDATE };
+
+  void tick_(uint32_t tick_us);
+  void call_(Entry &entry, Call call);
+  const Entry *find_(const Component *component) const;
+
+  std::vector<Entry> entries_;
+};
+
+}  // namespace host
+}  // namespace esphome
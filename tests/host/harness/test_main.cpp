@@ -0,0 +1,42 @@
+#include <cstring>
+
+#include "check.h"
+
+namespace esphome {
+namespace host {
+
+static int failures = 0;
+
+std::vector<TestCase> &test_cases() {
+  static std::vector<TestCase> cases;
+  return cases;
+}
+
+void record_failure(const char *file, int line, const char *expression) {
+  std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", file, line, expression);
+  failures++;
+}
+
+}  // namespace host
+}  // namespace esphome
+
+int main(int argc, char **argv) {
+  using namespace esphome::host;
+  int failed_cases = 0;
+  int run = 0;
+  for (const auto &test : test_cases()) {
+    bool selected = argc < 2;
+    for (int i = 1; i < argc; i++)
+      selected |= std::strcmp(argv[i], test.name) == 0;
+    if (!selected)
+      continue;
+    const int before = failures;
+    test.func();
+    run++;
+    const bool passed = failures == before;
+    failed_cases += passed ? 0 : 1;
+    std::printf("[%s] %s\n", passed ? "PASS" : "FAIL", test.name);
+  }
+  std::printf("%d of %d test cases passed\n", run - failed_cases, run);
+  return failed_cases == 0 && run > 0 ? 0 : 1;
+}
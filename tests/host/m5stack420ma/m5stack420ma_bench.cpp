@@ -0,0 +1,87 @@
+// Bus cost of the m5stack420ma component against an emulated module for a few bus clocks and
+// sampling setups: transactions per update, how long and how much of the time loop() blocks
+// the main loop, and the current sample rate achieved against what the bus allows.
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "module_rig.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+struct Scenario {
+  const char *name;
+  uint32_t frequency;
+  uint32_t sample_interval;  // 0: one sample per update
+  float nack_rate;
+};
+
+// ESPHome runs the main loop every 16ms unless a component asks for more
+static constexpr uint32_t LOOP_INTERVAL_US = 16000;
+static constexpr uint32_t UPDATE_INTERVAL = 5000;
+static constexpr uint32_t WARMUP = 6000;
+static constexpr uint32_t DURATION = 10 * 60 * 1000;
+
+static bool run_scenario(const Scenario &scenario) {
+  ModuleRig rig(scenario.frequency);
+  rig.component.set_update_interval(UPDATE_INTERVAL);
+  if (scenario.sample_interval != 0) {
+    rig.component.set_sample_interval(scenario.sample_interval);
+    rig.component.set_filter(m5stack420ma::FILTER_MEAN, 16, 0, 1.0f);
+  }
+  for (uint8_t ch = 0; ch < m5stack420ma::CHANNEL_COUNT; ch++)
+    rig.module.set_waveform(ch, waveform::sine(12.0f, 8.0f, 60000 + ch * 7000));
+  rig.module.set_nack_rate(scenario.nack_rate);
+  uint32_t published = 0;
+  rig.current[0].add_on_state_callback([&published](float value) {
+    if (!std::isnan(value))
+      published++;
+  });
+
+  rig.setup();
+  rig.app.run_for(WARMUP, LOOP_INTERVAL_US);
+  rig.module.reset_counters();
+  rig.bus.reset_counters();
+  published = 0;
+  const uint64_t blocking_before = rig.app.total_blocking_us(&rig.poller);
+  rig.app.run_for(DURATION, LOOP_INTERVAL_US);
+
+  const uint32_t updates = DURATION / UPDATE_INTERVAL;
+  const uint32_t transactions = rig.module.transactions();
+  const uint64_t blocking = rig.app.total_blocking_us(&rig.poller) - blocking_before;
+  const uint32_t burst_us = rig.bus.transfer_time_us(1) + rig.bus.transfer_time_us(2 * m5stack420ma::CHANNEL_COUNT);
+  std::printf("\n%s\n", scenario.name);
+  std::printf("  bus: %" PRIu32 " kHz, %.0f%% NACKs; sampling %s\n", scenario.frequency / 1000,
+              scenario.nack_rate * 100,
+              scenario.sample_interval == 0 ? "once per update" : "oversampled");
+  if (scenario.sample_interval != 0)
+    std::printf("  sample interval asked for: %" PRIu32 "ms\n", scenario.sample_interval);
+  std::printf("  %" PRIu32 " updates: %.1f transactions per update, %" PRIu32 " NACKed in total, %" PRIu32
+              " of %" PRIu32 " published\n",
+              updates, static_cast<double>(transactions) / updates, rig.module.nacks(), published, updates);
+  std::printf("  main loop blocked: longest loop() %" PRIu32 "us, %.1fus per transaction, %.3f%% of the time\n",
+              rig.app.max_blocking_us(&rig.poller), transactions != 0 ? static_cast<double>(blocking) / transactions : 0.0,
+              blocking / (DURATION * 10.0));
+  std::printf("  current sample rate: %.1f/s achieved, %.0f/s bus limit (%" PRIu32 "us per burst)\n",
+              rig.module.reads_of(ModuleEmulator::REG_CURRENT) * 1000.0 / DURATION, 1e6 / burst_us, burst_us);
+  return published != 0;
+}
+
+int main() {
+  // Injected NACKs would log a warning each; set HOST_LOG_LEVEL to see them anyway
+  setenv("HOST_LOG_LEVEL", "1", 0);
+  const Scenario scenarios[] = {
+      {"One sample per update", 100000, 0, 0.0f},
+      {"One sample per update, 400 kHz", 400000, 0, 0.0f},
+      {"Oversampling every 50ms", 100000, 50, 0.0f},
+      {"Oversampling as fast as loop() runs", 100000, 1, 0.0f},
+      {"Oversampling as fast as loop() runs, 400 kHz", 400000, 1, 0.0f},
+      {"Oversampling every 50ms, 2% NACKs", 100000, 50, 0.02f},
+  };
+  bool ok = true;
+  for (const auto &scenario : scenarios)
+    ok &= run_scenario(scenario);
+  return ok ? 0 : 1;
+}
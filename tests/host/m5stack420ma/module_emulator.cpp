@@ -0,0 +1,202 @@
+#include "module_emulator.h"
+#include "esphome/core/hal.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace esphome {
+namespace host {
+
+namespace waveform {
+
+Waveform constant(float ma) {
+  return [ma](uint32_t) { return ma; };
+}
+
+Waveform ramp(float from, float to, uint32_t period) {
+  return [from, to, period](uint32_t now) { return from + (to - from) * (now % period) / period; };
+}
+
+Waveform sine(float mean, float amplitude, uint32_t period) {
+  return [mean, amplitude, period](uint32_t now) {
+    return mean + amplitude * std::sin(2.0f * float(M_PI) * (now % period) / period);
+  };
+}
+
+Waveform steps(float initial, std::vector<std::pair<uint32_t, float>> steps) {
+  return [initial, steps](uint32_t now) {
+    float ma = initial;
+    for (const auto &step : steps) {
+      if (static_cast<int32_t>(now - step.first) < 0)
+        break;
+      ma = step.second;
+    }
+    return ma;
+  };
+}
+
+}  // namespace waveform
+
+ModuleEmulator::ModuleEmulator(uint8_t address, uint32_t seed) : address_(address), rng_(seed) {
+  for (auto &waveform : this->waveforms_)
+    waveform = waveform::constant(0.0f);
+}
+
+uint16_t ModuleEmulator::current_raw(uint8_t channel) const {
+  const float ma = this->waveforms_[channel](millis()) * this->gain_error_[channel];
+  return std::clamp(std::lround(ma * 100.0f * this->calibration_[channel]), 0L, 65535L);
+}
+
+uint16_t ModuleEmulator::adc_raw(uint8_t channel) const {
+  const float ma = this->waveforms_[channel](millis()) * this->gain_error_[channel];
+  return std::clamp(std::lround(ma / FULL_SCALE * 4095.0f), 0L, 4095L);
+}
+
+bool ModuleEmulator::acknowledge() {
+  this->transactions_++;
+  bool ack = this->present_;
+  if (this->storing_ && millis() - this->store_started_ < this->store_time_) {
+    this->nacks_while_storing_++;
+    ack = false;
+  }
+  if (this->nack_next_ != 0) {
+    this->nack_next_--;
+    ack = false;
+  } else if (this->nack_rate_ > 0.0f &&
+             std::uniform_real_distribution<float>(0.0f, 1.0f)(this->rng_) < this->nack_rate_) {
+    ack = false;
+  }
+  if (!ack)
+    this->nacks_++;
+  return ack;
+}
+
+void ModuleEmulator::write(const uint8_t *data, size_t len) {
+  if (len == 0)
+    return;
+  this->pointer_ = data[0];
+  const uint8_t reg = data[0];
+  if (len == 3 && reg >= REG_CAL && reg < REG_CAL + 2 * CHANNEL_COUNT && (reg - REG_CAL) % 2 == 0) {
+    // The written value is the current flowing right now; later readings are scaled to match
+    const uint8_t channel = (reg - REG_CAL) / 2;
+    const uint16_t value = data[1] | (data[2] << 8);
+    const float measured = this->waveforms_[channel](millis()) * this->gain_error_[channel] * 100.0f;
+    if (measured > 0.0f)
+      this->calibration_[channel] = value / measured;
+    this->calibration_writes_.push_back(CalibrationWrite{millis(), channel, value});
+    this->storing_ = true;
+    this->store_started_ = millis();
+  } else if (len == 2 && reg == REG_I2C_ADDRESS) {
+    this->address_ = data[1];
+  }
+}
+
+void ModuleEmulator::read(uint8_t *data, size_t len) {
+  const uint8_t start = this->pointer_;
+  if (start >= REG_CURRENT && start < REG_CURRENT + 2 * CHANNEL_COUNT) {
+    this->reads_current_++;
+  } else if (start >= REG_ADC_12BIT && start < REG_ADC_12BIT + 2 * CHANNEL_COUNT) {
+    this->reads_adc_12bit_++;
+  } else if (start >= REG_ADC_8BIT && start < REG_ADC_8BIT + CHANNEL_COUNT) {
+    this->reads_adc_8bit_++;
+  } else {
+    this->reads_other_++;
+  }
+  for (size_t i = 0; i < len; i++)
+    data[i] = this->register_(this->pointer_++);
+}
+
+uint8_t ModuleEmulator::register_(uint8_t reg) const {
+  if (reg < REG_ADC_12BIT + 2 * CHANNEL_COUNT) {
+    const uint16_t value = this->adc_raw(reg / 2);
+    return reg % 2 == 0 ? value & 0xFF : value >> 8;
+  }
+  if (reg >= REG_ADC_8BIT && reg < REG_ADC_8BIT + CHANNEL_COUNT)
+    return this->adc_raw(reg - REG_ADC_8BIT) >> 4;
+  if (reg >= REG_CURRENT && reg < REG_CURRENT + 2 * CHANNEL_COUNT) {
+    const uint16_t value = this->current_raw((reg - REG_CURRENT) / 2);
+    return reg % 2 == 0 ? value & 0xFF : value >> 8;
+  }
+  if (reg >= REG_CAL && reg < REG_CAL + 2 * CHANNEL_COUNT) {
+    const uint8_t channel = (reg - REG_CAL) / 2;
+    uint16_t value = 0;
+    for (const auto &write : this->calibration_writes_) {
+      if (write.channel == channel)
+        value = write.value;
+    }
+    return reg % 2 == 0 ? value & 0xFF : value >> 8;
+  }
+  if (reg == REG_FIRMWARE_VERSION)
+    return this->firmware_version_;
+  if (reg == REG_I2C_ADDRESS)
+    return this->address_;
+  return 0;
+}
+
+void ModuleEmulator::reset_counters() {
+  this->transactions_ = 0;
+  this->nacks_ = 0;
+  this->nacks_while_storing_ = 0;
+  this->reads_adc_12bit_ = 0;
+  this->reads_adc_8bit_ = 0;
+  this->reads_current_ = 0;
+  this->reads_other_ = 0;
+}
+
+uint32_t ModuleEmulator::reads_of(uint8_t base_reg) const {
+  switch (base_reg) {
+    case REG_ADC_12BIT:
+      return this->reads_adc_12bit_;
+    case REG_ADC_8BIT:
+      return this->reads_adc_8bit_;
+    case REG_CURRENT:
+      return this->reads_current_;
+    default:
+      return this->reads_other_;
+  }
+}
+
+uint32_t I2CBusEmulator::transfer_time_us(size_t len) const {
+  // Start, address and data bytes with their ACK bit, stop
+  const uint64_t bits = 1 + 9 * (1 + len) + 1;
+  return (bits * 1000000 + this->frequency_ - 1) / this->frequency_;
+}
+
+ModuleEmulator *I2CBusEmulator::find_(uint8_t address) const {
+  for (auto *module : this->modules_) {
+    if (module->get_address() == address)
+      return module;
+  }
+  return nullptr;
+}
+
+void I2CBusEmulator::spend_(uint32_t us) {
+  this->busy_us_ += us;
+  delayMicroseconds(us);
+}
+
+// A transaction starts with the register pointer write; a NACK ends it after the address byte
+i2c::ErrorCode I2CBusEmulator::write(uint8_t address, const uint8_t *buffer, size_t len, bool stop) {
+  ModuleEmulator *module = this->find_(address);
+  if (module == nullptr || !module->acknowledge()) {
+    this->spend_(this->transfer_time_us(0));
+    return i2c::ERROR_NOT_ACKNOWLEDGED;
+  }
+  this->spend_(this->transfer_time_us(len));
+  module->write(buffer, len);
+  return i2c::ERROR_OK;
+}
+
+i2c::ErrorCode I2CBusEmulator::read(uint8_t address, uint8_t *buffer, size_t len) {
+  ModuleEmulator *module = this->find_(address);
+  if (module == nullptr) {
+    this->spend_(this->transfer_time_us(0));
+    return i2c::ERROR_NOT_ACKNOWLEDGED;
+  }
+  this->spend_(this->transfer_time_us(len));
+  module->read(buffer, len);
+  return i2c::ERROR_OK;
+}
+
+}  // namespace host
+}  // namespace esphome
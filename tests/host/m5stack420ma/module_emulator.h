@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "esphome/components/i2c/i2c.h"
+
+namespace esphome {
+namespace host {
+
+// Loop current in mA at a given millis(); the tests script one per channel
+using Waveform = std::function<float(uint32_t)>;
+
+namespace waveform {
+Waveform constant(float ma);
+// Linear from `from` to `to` over `period` ms, then again from `from`
+Waveform ramp(float from, float to, uint32_t period);
+Waveform sine(float mean, float amplitude, uint32_t period);
+// `steps` holds (millis, mA) pairs in time order; the current before the first is `initial`
+Waveform steps(float initial, std::vector<std::pair<uint32_t, float>> steps);
+}  // namespace waveform
+
+// One CAL_REG write as the module received it
+struct CalibrationWrite {
+  uint32_t time;  // millis()
+  uint8_t channel;
+  uint16_t value;
+};
+
+// Register file of an M5Stack MODULE_4_20MA: 12-bit ADC at 0x00, 8-bit ADC at 0x10, current
+// (0.01 mA) at 0x20 and CAL at 0x30, two bytes little-endian per channel except the 8-bit ADC;
+// firmware version at 0xFE and the I2C address at 0xFF. Register values follow the scripted
+// waveforms at the time of the read. A CAL_REG write scales the channel so its current reads
+// the written value, and the module then answers nothing for store_time ms while it saves it.
+class ModuleEmulator {
+ public:
+  static constexpr uint8_t CHANNEL_COUNT = 4;
+  static constexpr uint8_t REG_ADC_12BIT = 0x00;
+  static constexpr uint8_t REG_ADC_8BIT = 0x10;
+  static constexpr uint8_t REG_CURRENT = 0x20;
+  static constexpr uint8_t REG_CAL = 0x30;
+  static constexpr uint8_t REG_FIRMWARE_VERSION = 0xFE;
+  static constexpr uint8_t REG_I2C_ADDRESS = 0xFF;
+  static constexpr float FULL_SCALE = 25.0f;  // mA at ADC full scale
+
+  explicit ModuleEmulator(uint8_t address = 0x55, uint32_t seed = 1);
+
+  uint8_t get_address() const { return this->address_; }
+  void set_firmware_version(uint8_t version) { this->firmware_version_ = version; }
+  void set_waveform(uint8_t channel, Waveform waveform) { this->waveforms_[channel] = std::move(waveform); }
+  // Factor by which the uncalibrated module misreads the channel's current
+  void set_gain_error(uint8_t channel, float gain) { this->gain_error_[channel] = gain; }
+  void set_store_time(uint32_t store_time) { this->store_time_ = store_time; }
+
+  // A module that is unplugged or powered off NACKs its address
+  void set_present(bool present) { this->present_ = present; }
+  // NACK the next `count` transactions, then answer normally again
+  void nack_next(uint32_t count) { this->nack_next_ = count; }
+  // NACK this share of transactions at random (seeded, so runs repeat)
+  void set_nack_rate(float rate) { this->nack_rate_ = rate; }
+
+  // Current in 0.01 mA the module reports for the channel right now
+  uint16_t current_raw(uint8_t channel) const;
+  uint16_t adc_raw(uint8_t channel) const;
+
+  // Bus side; false is a NACK
+  bool acknowledge();
+  void write(const uint8_t *data, size_t len);
+  void read(uint8_t *data, size_t len);
+
+  // Counters since construction or reset_counters()
+  void reset_counters();
+  uint32_t transactions() const { return this->transactions_; }
+  uint32_t nacks() const { return this->nacks_; }
+  uint32_t nacks_while_storing() const { return this->nacks_while_storing_; }
+  // Reads starting in the block of `base_reg`
+  uint32_t reads_of(uint8_t base_reg) const;
+  const std::vector<CalibrationWrite> &calibration_writes() const { return this->calibration_writes_; }
+
+ protected:
+  uint8_t register_(uint8_t reg) const;
+
+  uint8_t address_;
+  uint8_t firmware_version_{2};
+  Waveform waveforms_[CHANNEL_COUNT];
+  float gain_error_[CHANNEL_COUNT]{1.0f, 1.0f, 1.0f, 1.0f};
+  float calibration_[CHANNEL_COUNT]{1.0f, 1.0f, 1.0f, 1.0f};
+  uint8_t pointer_{0};
+  uint32_t store_time_{400};
+  bool storing_{false};
+  uint32_t store_started_{0};
+
+  bool present_{true};
+  uint32_t nack_next_{0};
+  float nack_rate_{0.0f};
+  std::mt19937 rng_;
+
+  uint32_t transactions_{0};
+  uint32_t nacks_{0};
+  uint32_t nacks_while_storing_{0};
+  uint32_t reads_adc_12bit_{0};
+  uint32_t reads_adc_8bit_{0};
+  uint32_t reads_current_{0};
+  uint32_t reads_other_{0};
+  std::vector<CalibrationWrite> calibration_writes_;
+};
+
+// I2C bus with emulated modules on it. Every transfer takes the time its bits need at the
+// configured clock, spent in delayMicroseconds() like the blocking driver on the chip, so it
+// shows up as main loop blocking time.
+class I2CBusEmulator : public i2c::I2CBus {
+ public:
+  explicit I2CBusEmulator(uint32_t frequency = 100000) : frequency_(frequency) {}
+
+  void set_frequency(uint32_t frequency) { this->frequency_ = frequency; }
+  uint32_t get_frequency() const { return this->frequency_; }
+  void add_module(ModuleEmulator *module) { this->modules_.push_back(module); }
+
+  i2c::ErrorCode read(uint8_t address, uint8_t *buffer, size_t len) override;
+  i2c::ErrorCode write(uint8_t address, const uint8_t *buffer, size_t len, bool stop = true) override;
+
+  // Time a transfer of `len` data bytes takes on the wire, in us
+  uint32_t transfer_time_us(size_t len) const;
+  void reset_counters() { this->busy_us_ = 0; }
+  uint64_t busy_us() const { return this->busy_us_; }
+
+ protected:
+  ModuleEmulator *find_(uint8_t address) const;
+  void spend_(uint32_t us);
+
+  uint32_t frequency_;
+  std::vector<ModuleEmulator *> modules_;
+  uint64_t busy_us_{0};
+};
+
+}  // namespace host
+}  // namespace esphome
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "esphome/components/m5stack420ma/m5stack420ma.h"
+#include "esphome/components/m5stack420ma/module_poller.h"
+#include "esphome/components/sensor/sensor.h"
+#include "host_app.h"
+#include "module_emulator.h"
+
+namespace esphome {
+namespace host {
+
+// Exposes the counters the component keeps for dump_config
+class TestModule : public m5stack420ma::M5Stack420MASensor {
+ public:
+  using M5Stack420MASensor::update_transactions_max_;
+};
+
+// An M5Stack420MASensor with a current and a raw ADC sensor on every channel and the
+// bus-wide poller the generated code always adds, on an emulated bus with one module.
+// Tests adjust the configuration before setup().
+struct ModuleRig {
+  explicit ModuleRig(uint32_t frequency = 100000) : bus(frequency) {
+    clear_preferences();
+    this->bus.add_module(&this->module);
+    this->component.set_i2c_bus(&this->bus);
+    this->component.set_i2c_address(0x55);
+    this->component.set_update_interval(5000);
+    this->component.set_poller(&this->poller);
+    for (uint8_t ch = 0; ch < m5stack420ma::CHANNEL_COUNT; ch++) {
+      this->current[ch].set_name("Current " + std::to_string(ch));
+      this->component.set_current_sensor(ch, &this->current[ch]);
+      this->raw_adc[ch].set_name("Raw ADC " + std::to_string(ch));
+      this->component.set_raw_adc_sensor(ch, &this->raw_adc[ch]);
+    }
+    this->app.register_component(&this->poller);
+    this->app.register_component(&this->component);
+  }
+
+  void setup() { this->app.setup(); }
+
+  I2CBusEmulator bus;
+  ModuleEmulator module;
+  m5stack420ma::ModulePoller poller;
+  TestModule component;
+  sensor::Sensor current[m5stack420ma::CHANNEL_COUNT];
+  sensor::Sensor raw_adc[m5stack420ma::CHANNEL_COUNT];
+  HostApp app;
+};
+
+}  // namespace host
+}  // namespace esphome
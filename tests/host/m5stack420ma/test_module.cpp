@@ -0,0 +1,109 @@
+#include <cmath>
+
+#include "check.h"
+#include "module_rig.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+static bool near(float actual, float expected) { return std::fabs(actual - expected) < 0.01f; }
+
+// The current burst reads 2 register bytes per channel after its register address
+static uint32_t burst_time_us(const ModuleRig &rig) {
+  return rig.bus.transfer_time_us(1) + rig.bus.transfer_time_us(2 * m5stack420ma::CHANNEL_COUNT);
+}
+
+// Each update publishes what the module reads at that moment
+TEST_CASE(publishes_scripted_currents) {
+  ModuleRig rig;
+  rig.module.set_waveform(0, waveform::constant(12.34f));
+  rig.module.set_waveform(1, waveform::steps(4.0f, {{20000, 16.0f}}));
+  rig.module.set_waveform(3, waveform::constant(20.0f));
+  rig.setup();
+  rig.app.run_for(6000);
+
+  CHECK(near(rig.current[0].state, 12.34f));
+  CHECK(near(rig.current[1].state, 4.0f));
+  CHECK(near(rig.current[2].state, 0.0f));
+  CHECK_EQ(rig.raw_adc[3].state, 3276.0f);
+  rig.app.run_for(20000);
+  CHECK(near(rig.current[1].state, 16.0f));
+  CHECK(near(rig.current[0].state, 12.34f));
+}
+
+// One ADC and one current burst per update, each in its own loop() iteration
+TEST_CASE(two_transactions_per_update) {
+  ModuleRig rig;
+  rig.setup();
+  rig.app.run_for(6000);
+  rig.module.reset_counters();
+  rig.app.run_for(10 * 5000);
+
+  CHECK_EQ(rig.module.transactions(), 20u);
+  CHECK_EQ(rig.module.reads_of(ModuleEmulator::REG_CURRENT), 10u);
+  CHECK_EQ(rig.module.reads_of(ModuleEmulator::REG_ADC_12BIT), 10u);
+  CHECK_EQ(rig.component.update_transactions_max_, 2);
+  CHECK_EQ(rig.app.max_blocking_us(&rig.poller), burst_time_us(rig));
+}
+
+// A NACK costs a retry within the same update, not the value
+TEST_CASE(nack_is_retried_within_the_update) {
+  ModuleRig rig;
+  rig.module.set_waveform(0, waveform::constant(8.0f));
+  rig.setup();
+  rig.app.run_for(6000);
+  rig.module.reset_counters();
+  rig.module.nack_next(1);
+  rig.current[0].state = NAN;
+  rig.app.run_for(5000);
+
+  CHECK_EQ(rig.module.nacks(), 1u);
+  CHECK_EQ(rig.module.transactions(), 3u);
+  CHECK(near(rig.current[0].state, 8.0f));
+}
+
+// A module that stops answering goes unavailable and is only probed, with backoff, until
+// it is back
+TEST_CASE(offline_and_recovery) {
+  ModuleRig rig;
+  rig.module.set_waveform(0, waveform::constant(8.0f));
+  rig.setup();
+  rig.app.run_for(6000);
+  rig.module.set_present(false);
+  rig.app.run_for(15000);
+
+  CHECK(std::isnan(rig.current[0].state));
+  CHECK(rig.component.status_has_warning());
+  rig.module.reset_counters();
+  rig.app.run_for(10 * 60000);
+  // 1s, 2s, ... 32s, then every 60s
+  CHECK(rig.module.transactions() <= 16u);
+
+  rig.module.set_present(true);
+  rig.app.run_for(70000);
+  CHECK(!rig.component.status_has_warning());
+  CHECK(near(rig.current[0].state, 8.0f));
+}
+
+// Reference currents go to CAL_REG one per loop() step, 500ms apart, so the module is never
+// addressed while it stores the previous one, and the main loop never waits for it
+TEST_CASE(device_calibration_waits_for_the_module_to_store) {
+  ModuleRig rig;
+  rig.module.set_waveform(0, waveform::constant(10.0f));
+  rig.module.set_gain_error(0, 1.05f);
+  rig.module.set_waveform(1, waveform::constant(10.0f));
+  rig.module.set_gain_error(1, 0.97f);
+  rig.component.set_device_calibration(0, 1000);
+  rig.component.set_device_calibration(1, 1000);
+  rig.setup();
+  rig.app.run_for(6000);
+
+  const auto &writes = rig.module.calibration_writes();
+  CHECK_EQ(writes.size(), 2u);
+  if (writes.size() == 2)
+    CHECK(writes[1].time - writes[0].time >= m5stack420ma::CALIBRATION_SETTLE);
+  CHECK_EQ(rig.module.nacks_while_storing(), 0u);
+  CHECK(rig.app.max_blocking_us(&rig.poller) <= burst_time_us(rig));
+  CHECK(near(rig.current[0].state, 10.0f));
+  CHECK(near(rig.current[1].state, 10.0f));
+}
@@ -0,0 +1,140 @@
+// Bus cost and freshness of the save_vtr poll scheduler for a few link configurations:
+// transactions and bytes per poll cycle, bus occupancy, time from a register changing on
+// the unit to its sensor publishing the new value, and heap allocations per poll cycle.
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "alloc_counter.h"
+#include "vtr_rig.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+struct Scenario {
+  const char *name;
+  LinkConfig link;
+  uint16_t command_throttle;
+  uint32_t saf_poll_interval;  // 0: update_interval
+};
+
+// One register whose value the bench changes on the unit, and the sensor that should follow
+struct FreshnessProbe {
+  const char *name;
+  ModbusRegisterType register_type;
+  uint16_t address;
+  sensor::Sensor *sensor;
+  float scale;
+  uint16_t base;
+  float expected{NAN};
+  uint32_t changed_at{0};
+  uint32_t count{0};
+  uint32_t max{0};
+  uint64_t total{0};
+};
+
+static constexpr uint32_t WARMUP = 5000;
+static constexpr uint32_t DURATION = 30 * 60 * 1000;
+static constexpr uint32_t CHANGE_INTERVAL = 47000;  // not a multiple of any poll interval
+
+static bool run_scenario(const Scenario &scenario) {
+  VTRRig rig(scenario.link, scenario.command_throttle);
+  if (scenario.saf_poll_interval != 0)
+    rig.climate.set_poll_interval(save_vtr::REGISTER_SUPPLY_AIRFLOW, scenario.saf_poll_interval);
+
+  std::vector<FreshnessProbe> probes = {
+      {"supply_air_temp", ModbusRegisterType::HOLDING, VTRSimulator::REG_SUPPLY_TEMP, &rig.supply_air_temp, 0.1f, 183},
+      {"outdoor_air_temp", ModbusRegisterType::HOLDING, VTRSimulator::REG_OUTDOOR_TEMP, &rig.outdoor_air_temp, 0.1f,
+       52},
+      {"extract_air_temp", ModbusRegisterType::HOLDING, VTRSimulator::REG_EXTRACT_TEMP, &rig.extract_air_temp, 0.1f,
+       221},
+      {"heat_demand", ModbusRegisterType::READ, VTRSimulator::REG_HEAT_DEMAND, &rig.heat_demand, 1.0f, 35},
+      {"saf_volume", ModbusRegisterType::READ, VTRSimulator::REG_SUPPLY_AIRFLOW, &rig.saf_volume, 3.0f, 60},
+      {"rpm_eaf", ModbusRegisterType::READ, VTRSimulator::REG_RPM_EAF, &rig.rpm_eaf, 1.0f, 1740},
+  };
+  for (auto &probe : probes) {
+    FreshnessProbe *p = &probe;
+    probe.sensor->add_on_state_callback([p](float value) {
+      if (std::isnan(p->expected) || std::fabs(value - p->expected) > 0.01f)
+        return;
+      const uint32_t latency = millis() - p->changed_at;
+      p->count++;
+      p->total += latency;
+      p->max = std::max(p->max, latency);
+      p->expected = NAN;
+    });
+  }
+
+  rig.setup();
+  rig.app.run_for(WARMUP);
+  rig.sim.reset_counters();
+  const uint32_t cycles_before = rig.climate.get_fieldbus_stats().cycles();
+  const uint64_t allocations_before = allocation_count();
+  const uint64_t external_before = external_allocation_count();
+
+  uint32_t step = 0;
+  for (uint32_t elapsed = 0; elapsed < DURATION; elapsed += 1000) {
+    if (elapsed % CHANGE_INTERVAL == 0) {
+      step++;
+      for (auto &probe : probes) {
+        const uint16_t raw = probe.base + (step % 2 == 0 ? 0 : 7);
+        rig.sim.set_register(probe.register_type, probe.address, raw);
+        probe.expected = raw * probe.scale;
+        probe.changed_at = millis();
+      }
+    }
+    rig.app.run_for(1000);
+  }
+
+  const uint32_t cycles = rig.climate.get_fieldbus_stats().cycles() - cycles_before;
+  const uint64_t allocations = allocation_count() - allocations_before;
+  const uint64_t external = external_allocation_count() - external_before;
+  std::printf("\n%s\n", scenario.name);
+  std::printf("  link: %" PRIu32 " baud, %" PRIu32 "us turnaround, throttle %ums, %.0f%% dropped, %.0f%% CRC errors\n",
+              scenario.link.baud_rate, scenario.link.response_latency_us, scenario.command_throttle,
+              scenario.link.drop_rate * 100, scenario.link.crc_error_rate * 100);
+  if (cycles == 0) {
+    std::printf("  no poll cycle completed\n");
+    return false;
+  }
+  std::printf("  %" PRIu32 " poll cycles: %.1f transactions, %.0f bytes on the wire per cycle, bus busy %.2f%%\n",
+              cycles, static_cast<double>(rig.sim.requests()) / cycles,
+              static_cast<double>(rig.sim.bytes_on_wire()) / cycles, rig.sim.busy_us() / (DURATION * 10.0));
+  std::printf("  heap allocations per cycle: %.2f by the component, %.2f by the controller queue\n",
+              static_cast<double>(allocations) / cycles, static_cast<double>(external) / cycles);
+  std::printf("  time to fresh value (mean / max):\n");
+  bool ok = true;
+  for (const auto &probe : probes) {
+    if (probe.count == 0) {
+      std::printf("    %-18s never updated\n", probe.name);
+      ok = false;
+      continue;
+    }
+    std::printf("    %-18s %6" PRIu64 "ms / %6" PRIu32 "ms (%" PRIu32 " changes)\n", probe.name,
+                probe.total / probe.count, probe.max, probe.count);
+  }
+  return ok;
+}
+
+int main() {
+  LinkConfig slow;
+  LinkConfig fast;
+  fast.baud_rate = 19200;
+  fast.response_latency_us = 10000;
+  LinkConfig lossy;
+  lossy.drop_rate = 0.05f;
+  lossy.crc_error_rate = 0.02f;
+
+  const Scenario scenarios[] = {
+      {"Example configuration (update_interval 30s)", slow, 200, 0},
+      {"Airflow polled every 10s", slow, 200, 10000},
+      {"Command throttle 50ms", slow, 50, 0},
+      {"19200 baud, 10ms turnaround, throttle 50ms", fast, 50, 0},
+      {"Lossy link", lossy, 200, 0},
+  };
+  bool ok = true;
+  for (const auto &scenario : scenarios)
+    ok &= run_scenario(scenario);
+  return ok ? 0 : 1;
+}
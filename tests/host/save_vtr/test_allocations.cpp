@@ -0,0 +1,44 @@
+#include "alloc_counter.h"
+#include "check.h"
+#include "vtr_rig.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+// Once set up, polling costs the component no heap allocation: the read commands are built
+// in setup() and their copies hold a small handler and an empty payload. What remains is the
+// controller's own queue entry per command (the item and its list node).
+TEST_CASE(poll_path_does_not_allocate) {
+  VTRRig rig;
+  rig.climate.set_poll_interval(save_vtr::REGISTER_SUPPLY_AIRFLOW, 10000);
+  rig.climate.get_trace().set_capacity(64);
+  save_vtr::WindowAggregator aggregator;
+  sensor::Sensor mean;
+  aggregator.set_mean_sensor(&mean);
+  rig.climate.add_aggregator(&rig.saf_volume, &aggregator);
+  rig.setup();
+  rig.app.run_for(60000);
+
+  rig.sim.reset_counters();
+  const uint64_t allocations = allocation_count();
+  const uint64_t external = external_allocation_count();
+  rig.app.run_for(600000);
+
+  CHECK(rig.sim.requests() > 100);
+  CHECK_EQ(allocation_count() - allocations, 0u);
+  CHECK_EQ(external_allocation_count() - external, 2u * rig.sim.requests());
+}
+
+// The copy queue_command() makes of a read command, minus the controller's own queue entry
+TEST_CASE(read_command_copy_does_not_allocate) {
+  VTRRig rig;
+  size_t index = 3;
+  auto *target = &rig.climate;
+  const auto command = modbus_controller::ModbusCommandItem::create_read_command(
+      &rig.controller, ModbusRegisterType::READ, 14000, 2,
+      [target, index](ModbusRegisterType, uint16_t, const std::vector<uint8_t> &) { (void) target, (void) index; });
+  const uint64_t allocations = allocation_count();
+  modbus_controller::ModbusCommandItem copy = command;
+  CHECK_EQ(allocation_count() - allocations, 0u);
+  CHECK(copy.is_equal(command));
+}
@@ -0,0 +1,215 @@
+#include <cmath>
+
+#include "check.h"
+#include "vtr_rig.h"
+
+using namespace esphome;
+using namespace esphome::host;
+using modbus_controller::ModbusFunctionCode;
+
+// Holding 2000, 12101..12102, 12543 and input 1160, 2148, 12400..12401, 14000..14001
+static constexpr uint32_t PLANNED_READS = 7;
+
+static bool near(float actual, float expected) { return std::fabs(actual - expected) < 0.01f; }
+
+// setup() reads every block once, straight away, and the first cycle publishes everything
+TEST_CASE(first_cycle_publishes_every_value) {
+  VTRRig rig;
+  rig.setup();
+  rig.app.run_for(5000);
+
+  CHECK_EQ(rig.sim.reads(), PLANNED_READS);
+  CHECK_EQ(rig.sim.requests(), PLANNED_READS);
+  CHECK_EQ(rig.climate.get_fieldbus_stats().cycles(), 1u);
+  CHECK(near(rig.climate.target_temperature, 21.0f));
+  CHECK(near(rig.climate.current_temperature, 18.3f));
+  CHECK(near(rig.outdoor_air_temp.state, 5.2f));
+  CHECK(near(rig.extract_air_temp.state, 22.1f));
+  CHECK(near(rig.saf_percent.state, 60.0f));
+  CHECK(near(rig.saf_volume.state, 180.0f));
+  CHECK(near(rig.eaf_volume.state, 174.0f));
+  CHECK(near(rig.heat_demand.state, 35.0f));
+  CHECK(near(rig.rpm_saf.state, 1810.0f));
+  CHECK(near(rig.rpm_eaf.state, 1740.0f));
+  CHECK(rig.climate.has_custom_fan_mode() && rig.climate.get_custom_fan_mode().str() == "MANUAL");
+  CHECK(rig.stale.has_state() && !rig.stale.state);
+}
+
+// Every update_interval tick reads each default block once, and nothing in between
+TEST_CASE(update_reads_each_block_once) {
+  VTRRig rig;
+  rig.setup();
+  rig.app.run_for(5000);
+  rig.sim.reset_counters();
+  rig.app.run_for(10 * 30000);
+
+  CHECK_EQ(rig.sim.reads(), 10 * PLANNED_READS);
+  CHECK_EQ(rig.sim.reads_of(ModbusRegisterType::HOLDING, VTRSimulator::REG_SETPOINT), 10u);
+  CHECK_EQ(rig.sim.reads_of(ModbusRegisterType::READ, VTRSimulator::REG_SUPPLY_AIRFLOW), 10u);
+  CHECK_EQ(rig.sim.writes(), 0u);
+}
+
+// A register with its own poll_interval is read on that interval, independent of update()
+TEST_CASE(per_register_poll_intervals) {
+  VTRRig rig;
+  rig.climate.set_poll_interval(save_vtr::REGISTER_SUPPLY_AIRFLOW, 10000);
+  rig.climate.set_poll_interval(save_vtr::REGISTER_EXTRACT_AIRFLOW, 10000);
+  rig.climate.set_poll_interval(save_vtr::REGISTER_EXTRACT_TEMP, 300000);
+  rig.setup();
+  rig.app.run_for(5000);
+  rig.sim.reset_counters();
+  rig.app.run_for(600000);
+
+  CHECK_EQ(rig.sim.reads_of(ModbusRegisterType::READ, VTRSimulator::REG_SUPPLY_AIRFLOW), 60u);
+  CHECK_EQ(rig.sim.reads_of(ModbusRegisterType::HOLDING, VTRSimulator::REG_EXTRACT_TEMP), 2u);
+  CHECK_EQ(rig.sim.reads_of(ModbusRegisterType::HOLDING, VTRSimulator::REG_SETPOINT), 20u);
+}
+
+// A write goes out ahead of the reads still waiting in the cycle and is read back right after
+TEST_CASE(write_goes_before_pending_reads) {
+  VTRRig rig;
+  rig.setup();
+  rig.app.run_for(5000);
+  // Let the next update() start its cycle, then change the setpoint while it runs
+  rig.app.run_until([&rig]() { return rig.controller.get_queue_size() != 0; }, 31000);
+  rig.sim.reset_counters();
+  rig.sim.set_record_requests(true);
+  auto call = rig.climate.make_call();
+  call.set_target_temperature(23.0f);
+  call.perform();
+  rig.app.run_for(5000);
+
+  const auto &log = rig.sim.request_log();
+  size_t write = log.size();
+  for (size_t i = 0; i < log.size(); i++) {
+    if (log[i].function_code == ModbusFunctionCode::WRITE_SINGLE_REGISTER) {
+      write = i;
+      break;
+    }
+  }
+  CHECK(write < log.size());
+  if (write + 1 < log.size()) {
+    CHECK(log[write].address == VTRSimulator::REG_SETPOINT);
+    // Read back first, then the rest of the cycle
+    CHECK(log[write + 1].function_code == ModbusFunctionCode::READ_HOLDING_REGISTERS);
+    CHECK(log[write + 1].address == VTRSimulator::REG_SETPOINT);
+    CHECK(write + 2 < log.size());
+  }
+  CHECK_EQ(rig.sim.writes(), 1u);
+  CHECK_EQ(rig.sim.get_register(ModbusRegisterType::HOLDING, VTRSimulator::REG_SETPOINT), 230);
+  CHECK(near(rig.climate.target_temperature, 23.0f));
+}
+
+// Setpoint changes within write_debounce collapse into one write of the last value
+TEST_CASE(writes_are_debounced) {
+  VTRRig rig;
+  rig.setup();
+  rig.app.run_for(5000);
+  for (float temperature : {22.0f, 22.5f, 24.0f}) {
+    auto call = rig.climate.make_call();
+    call.set_target_temperature(temperature);
+    call.perform();
+    rig.app.run_for(100);
+  }
+  rig.app.run_for(3000);
+
+  CHECK_EQ(rig.sim.writes(), 1u);
+  CHECK_EQ(rig.sim.get_register(ModbusRegisterType::HOLDING, VTRSimulator::REG_SETPOINT), 240);
+}
+
+// Ready writes to adjacent registers go out as one Write Multiple Registers frame. The
+// unit's own writable registers are not adjacent, so this writes test registers.
+TEST_CASE(adjacent_writes_merge_into_one_frame) {
+  VTRRig rig;
+  for (uint16_t address = 3000; address <= 3004; address++)
+    rig.sim.set_register(ModbusRegisterType::HOLDING, address, 0);
+  rig.setup();
+  rig.app.run_for(5000);
+  rig.sim.reset_counters();
+  rig.sim.set_record_requests(true);
+  rig.climate.queue_write_(3002, 7, save_vtr::REGISTER_SETPOINT);
+  rig.climate.queue_write_(3000, 5, save_vtr::REGISTER_SETPOINT);
+  rig.climate.queue_write_(3004, 9, save_vtr::REGISTER_SETPOINT);
+  rig.climate.queue_write_(3001, 6, save_vtr::REGISTER_SETPOINT);
+  rig.app.run_for(3000);
+
+  const auto &log = rig.sim.request_log();
+  CHECK(log.size() >= 3);
+  if (log.size() >= 3) {
+    CHECK(log[0].function_code == ModbusFunctionCode::WRITE_MULTIPLE_REGISTERS);
+    CHECK_EQ(log[0].address, 3000);
+    CHECK_EQ(log[0].count, 3);
+    // 3004 is not adjacent and gets a frame of its own, still ahead of the read-back
+    CHECK(log[1].function_code == ModbusFunctionCode::WRITE_SINGLE_REGISTER);
+    CHECK_EQ(log[1].address, 3004);
+    CHECK(log[2].function_code == ModbusFunctionCode::READ_HOLDING_REGISTERS);
+    CHECK_EQ(log[2].address, VTRSimulator::REG_SETPOINT);
+  }
+  CHECK_EQ(rig.sim.writes(), 2u);
+  CHECK_EQ(rig.sim.get_register(ModbusRegisterType::HOLDING, 3000), 5);
+  CHECK_EQ(rig.sim.get_register(ModbusRegisterType::HOLDING, 3001), 6);
+  CHECK_EQ(rig.sim.get_register(ModbusRegisterType::HOLDING, 3002), 7);
+  CHECK_EQ(rig.sim.get_register(ModbusRegisterType::HOLDING, 3004), 9);
+}
+
+// With write_multiple off every write is a frame of its own
+TEST_CASE(write_multiple_off_sends_single_writes) {
+  VTRRig rig;
+  rig.climate.set_write_multiple(false);
+  for (uint16_t address = 3000; address <= 3001; address++)
+    rig.sim.set_register(ModbusRegisterType::HOLDING, address, 0);
+  rig.setup();
+  rig.app.run_for(5000);
+  rig.sim.reset_counters();
+  rig.climate.queue_write_(3000, 5, save_vtr::REGISTER_SETPOINT);
+  rig.climate.queue_write_(3001, 6, save_vtr::REGISTER_SETPOINT);
+  rig.app.run_for(3000);
+
+  CHECK_EQ(rig.sim.writes(), 2u);
+  CHECK_EQ(rig.sim.get_register(ModbusRegisterType::HOLDING, 3000), 5);
+  CHECK_EQ(rig.sim.get_register(ModbusRegisterType::HOLDING, 3001), 6);
+}
+
+// An unanswering unit is taken offline, probed with backoff and fully polled once it is back
+TEST_CASE(offline_and_recovery) {
+  VTRRig rig;
+  rig.setup();
+  rig.app.run_for(5000);
+  rig.sim.set_online(false);
+  CHECK(rig.app.run_until([&rig]() { return rig.climate.get_health() == save_vtr::HEALTH_OFFLINE; }, 120000));
+  CHECK(std::isnan(rig.supply_air_temp.state));
+  CHECK(std::isnan(rig.climate.current_temperature));
+
+  // Offline, only the probe goes on the bus: with backoff at most two probes a minute by now,
+  // each resent by the controller up to max_cmd_retries times
+  rig.app.run_for(60000);
+  rig.sim.reset_counters();
+  rig.app.run_for(60000);
+  CHECK(rig.sim.requests() <= 2 * 5);
+
+  rig.sim.set_online(true);
+  rig.sim.reset_counters();
+  CHECK(rig.app.run_until([&rig]() { return rig.climate.get_health() == save_vtr::HEALTH_ONLINE; }, 310000));
+  rig.app.run_for(5000);
+  CHECK(rig.sim.reads() >= PLANNED_READS);
+  CHECK(near(rig.supply_air_temp.state, 18.3f));
+  CHECK(near(rig.climate.current_temperature, 18.3f));
+}
+
+// Dropped and corrupted frames cost retries but every value still arrives
+TEST_CASE(lossy_link_converges) {
+  LinkConfig link;
+  link.drop_rate = 0.1f;
+  link.crc_error_rate = 0.05f;
+  link.seed = 7;
+  VTRRig rig(link);
+  rig.setup();
+  rig.app.run_for(600000);
+
+  CHECK(rig.sim.dropped() > 0);
+  CHECK(rig.sim.crc_errors() > 0);
+  CHECK(rig.climate.get_health() != save_vtr::HEALTH_OFFLINE);
+  CHECK(rig.climate.get_fieldbus_stats().cycles() >= 19);
+  CHECK(near(rig.supply_air_temp.state, 18.3f));
+  CHECK(near(rig.rpm_eaf.state, 1740.0f));
+}
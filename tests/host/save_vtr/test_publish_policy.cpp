@@ -0,0 +1,94 @@
+#include <cmath>
+
+#include "check.h"
+#include "vtr_rig.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+// Publishes of a sensor after setup
+struct PublishCounter {
+  explicit PublishCounter(sensor::Sensor &sensor) {
+    sensor.add_on_state_callback([this](float) { this->count++; });
+  }
+  uint32_t count{0};
+};
+
+// A value is published again only once it moved more than the deadband from the last
+// published one, not on every cycle
+TEST_CASE(deadband_suppresses_small_changes) {
+  VTRRig rig;
+  rig.climate.set_publish_policy(&rig.outdoor_air_temp, 0.5f, 0.0f, 0);
+  PublishCounter published(rig.outdoor_air_temp);
+  rig.setup();
+  rig.app.run_for(5000);
+  CHECK_EQ(published.count, 1u);
+
+  // 5.2 -> 5.4 -> 5.6: within 0.5 of the published 5.2
+  rig.sim.set_register(ModbusRegisterType::HOLDING, VTRSimulator::REG_OUTDOOR_TEMP, 54);
+  rig.app.run_for(30000);
+  rig.sim.set_register(ModbusRegisterType::HOLDING, VTRSimulator::REG_OUTDOOR_TEMP, 56);
+  rig.app.run_for(30000);
+  CHECK_EQ(published.count, 1u);
+  CHECK(std::fabs(rig.outdoor_air_temp.state - 5.2f) < 0.01f);
+
+  // 5.8 is 0.6 from 5.2, which becomes the reference for the next change
+  rig.sim.set_register(ModbusRegisterType::HOLDING, VTRSimulator::REG_OUTDOOR_TEMP, 58);
+  rig.app.run_for(30000);
+  CHECK_EQ(published.count, 2u);
+  CHECK(std::fabs(rig.outdoor_air_temp.state - 5.8f) < 0.01f);
+  rig.sim.set_register(ModbusRegisterType::HOLDING, VTRSimulator::REG_OUTDOOR_TEMP, 62);
+  rig.app.run_for(30000);
+  CHECK_EQ(published.count, 2u);
+}
+
+// The relative deadband scales with the last published value
+TEST_CASE(relative_deadband_scales_with_value) {
+  VTRRig rig;
+  rig.climate.set_publish_policy(&rig.rpm_saf, 0.0f, 0.1f, 0);
+  PublishCounter published(rig.rpm_saf);
+  rig.setup();
+  rig.app.run_for(5000);
+  CHECK_EQ(published.count, 1u);
+
+  // 1810 rpm: 181 rpm needed
+  rig.sim.set_register(ModbusRegisterType::READ, VTRSimulator::REG_RPM_SAF, 1980);
+  rig.app.run_for(30000);
+  CHECK_EQ(published.count, 1u);
+  rig.sim.set_register(ModbusRegisterType::READ, VTRSimulator::REG_RPM_SAF, 2000);
+  rig.app.run_for(30000);
+  CHECK_EQ(published.count, 2u);
+  CHECK_EQ(rig.rpm_saf.state, 2000.0f);
+}
+
+// The larger of the two thresholds applies
+TEST_CASE(larger_deadband_wins) {
+  VTRRig rig;
+  rig.climate.set_publish_policy(&rig.outdoor_air_temp, 0.5f, 0.5f, 0);
+  PublishCounter published(rig.outdoor_air_temp);
+  rig.setup();
+  rig.app.run_for(5000);
+
+  // 0.6 is past the absolute deadband but not past half of 5.2
+  rig.sim.set_register(ModbusRegisterType::HOLDING, VTRSimulator::REG_OUTDOOR_TEMP, 58);
+  rig.app.run_for(30000);
+  CHECK_EQ(published.count, 1u);
+  rig.sim.set_register(ModbusRegisterType::HOLDING, VTRSimulator::REG_OUTDOOR_TEMP, 80);
+  rig.app.run_for(30000);
+  CHECK_EQ(published.count, 2u);
+}
+
+// An unchanged value is republished every heartbeat, even when update_interval is longer
+TEST_CASE(heartbeat_republishes_between_samples) {
+  VTRRig rig;
+  rig.climate.set_update_interval(300000);
+  rig.climate.set_publish_policy(&rig.outdoor_air_temp, 0.5f, 0.0f, 60000);
+  PublishCounter published(rig.outdoor_air_temp);
+  rig.setup();
+  rig.app.run_for(5000);
+  CHECK_EQ(published.count, 1u);
+
+  rig.app.run_for(4 * 60000);
+  CHECK_EQ(published.count, 1u + 4u);
+  CHECK(std::fabs(rig.outdoor_air_temp.state - 5.2f) < 0.01f);
+}
@@ -0,0 +1,221 @@
+#include <cmath>
+#include <memory>
+#include <string>
+
+#include "check.h"
+#include "vtr_rig.h"
+
+using namespace esphome;
+using namespace esphome::host;
+using modbus_controller::ModbusFunctionCode;
+
+// One request as the shared line saw it
+struct BusEvent {
+  uint8_t unit;
+  uint64_t start_us;
+  uint64_t end_us;
+  ModbusFunctionCode function_code;
+  uint16_t address;
+};
+
+// Puts one unit's requests on a line shared with the other units: forwards them to the
+// unit's simulator and logs when each one started and how long it kept the line busy
+class BusTap : public modbus_controller::ModbusTransport {
+ public:
+  BusTap(uint8_t unit, VTRSimulator *sim, std::vector<BusEvent> *log) : unit_(unit), sim_(sim), log_(log) {}
+
+  modbus_controller::TransportResult transact(const modbus_controller::ModbusCommandItem &command,
+                                              std::vector<uint8_t> &response, uint32_t &wire_time_us) override {
+    const auto result = this->sim_->transact(command, response, wire_time_us);
+    const uint64_t start = time_us();
+    this->log_->push_back({this->unit_, start, start + wire_time_us, command.function_code, command.register_address});
+    return result;
+  }
+
+ protected:
+  uint8_t unit_;
+  VTRSimulator *sim_;
+  std::vector<BusEvent> *log_;
+};
+
+// Two SAVE VTR units with every polled register on one modbus, sharing a BusCoordinator the
+// way the generated code wires it
+struct SharedBusRig {
+  struct Unit {
+    Unit(uint8_t index, std::vector<BusEvent> *log) : tap(index, &sim, log) {}
+
+    VTRSimulator sim;
+    BusTap tap;
+    modbus_controller::ModbusController controller;
+    TestClimate climate;
+  };
+
+  explicit SharedBusRig(uint8_t budget_a = 1, uint8_t budget_b = 1) {
+    clear_preferences();
+    const uint8_t budgets[2] = {budget_a, budget_b};
+    for (uint8_t i = 0; i < 2; i++) {
+      this->units[i] = std::make_unique<Unit>(i, &this->log);
+      Unit &unit = *this->units[i];
+      unit.controller.set_transport(&unit.tap);
+      unit.controller.set_command_throttle(200);
+      unit.climate.set_name(i == 0 ? "SAVE A" : "SAVE B");
+      unit.climate.set_modbus(&unit.controller);
+      unit.climate.set_update_interval(30000);
+      for (auto id : {save_vtr::REGISTER_SUPPLY_AIRFLOW, save_vtr::REGISTER_EXTRACT_AIRFLOW,
+                      save_vtr::REGISTER_HEAT_DEMAND, save_vtr::REGISTER_OUTDOOR_TEMP, save_vtr::REGISTER_EXTRACT_TEMP,
+                      save_vtr::REGISTER_RPM_SAF, save_vtr::REGISTER_RPM_EAF})
+        unit.climate.add_polled_register(id);
+      unit.climate.set_bus_coordinator(&this->coordinator, budgets[i]);
+    }
+    this->utilization.set_name("Bus Utilization");
+    this->units[0]->climate.set_bus_utilization_sensor(&this->utilization);
+
+    this->app.register_component(&this->coordinator);
+    for (auto &unit : this->units) {
+      this->app.register_component(&unit->controller);
+      this->app.register_component(&unit->climate);
+    }
+  }
+
+  void setup() { this->app.setup(); }
+
+  // Events that started at or after `since_us`, as a string of unit letters
+  std::string turns(uint64_t since_us = 0) const {
+    std::string turns;
+    for (const auto &event : this->log) {
+      if (event.start_us >= since_us)
+        turns += static_cast<char>('A' + event.unit);
+    }
+    return turns;
+  }
+
+  std::vector<BusEvent> log;
+  save_vtr::BusCoordinator coordinator;
+  std::unique_ptr<Unit> units[2];
+  sensor::Sensor utilization;
+  HostApp app;
+};
+
+// Holding 2000, 12101..12102, 12543 and input 1160, 2148, 12400..12401, 14000..14001
+static constexpr uint32_t PLANNED_READS = 7;
+
+// Commands of the two units never overlap on the line, and both units are fully polled
+TEST_CASE(shared_bus_one_command_at_a_time) {
+  SharedBusRig rig;
+  rig.setup();
+  rig.app.run_for(10 * 30000 + 20000);
+
+  uint32_t overlaps = 0;
+  for (size_t i = 1; i < rig.log.size(); i++) {
+    if (rig.log[i].start_us < rig.log[i - 1].end_us)
+      overlaps++;
+  }
+  CHECK_EQ(overlaps, 0u);
+  CHECK(rig.units[0]->sim.reads() >= 10 * PLANNED_READS);
+  CHECK(rig.units[1]->sim.reads() >= 10 * PLANNED_READS);
+  CHECK(std::fabs(rig.units[0]->climate.current_temperature - 18.3f) < 0.01f);
+  CHECK(std::fabs(rig.units[1]->climate.current_temperature - 18.3f) < 0.01f);
+}
+
+// setup() makes both units poll at once; with a budget of one command each they take turns
+TEST_CASE(shared_bus_turns_alternate) {
+  SharedBusRig rig;
+  rig.setup();
+  rig.app.run_for(10000);
+
+  CHECK(rig.turns() == "ABABABABABABAB");
+}
+
+// A unit with a budget of two sends two commands per turn while the other one waits
+TEST_CASE(shared_bus_budget_per_turn) {
+  SharedBusRig rig(2, 1);
+  rig.setup();
+  rig.app.run_for(10000);
+
+  CHECK(rig.turns() == "AABAABAABABBBB");
+}
+
+// A write of one unit goes on the line ahead of the other unit's pending reads, even in the
+// middle of that unit's turn
+TEST_CASE(shared_bus_write_goes_before_other_units_reads) {
+  SharedBusRig rig(3, 1);
+  rig.units[1]->climate.set_write_debounce(0);
+  rig.setup();
+  // Change B's setpoint while A sends the first of the three reads of its turn
+  rig.app.run_until([&rig]() { return rig.log.size() == 1; }, 5000);
+  const uint64_t call_us = time_us();
+  auto call = rig.units[1]->climate.make_call();
+  call.set_target_temperature(23.0f);
+  call.perform();
+  rig.app.run_for(10000);
+
+  size_t next = rig.log.size();
+  for (size_t i = 0; i < rig.log.size(); i++) {
+    if (rig.log[i].start_us > call_us) {
+      next = i;
+      break;
+    }
+  }
+  CHECK(next + 1 < rig.log.size());
+  if (next + 1 < rig.log.size()) {
+    CHECK_EQ(rig.log[next].unit, 1u);
+    CHECK(rig.log[next].function_code == ModbusFunctionCode::WRITE_SINGLE_REGISTER);
+    // The read-back is urgent too and goes before A's next read
+    CHECK_EQ(rig.log[next + 1].unit, 1u);
+    CHECK(rig.log[next + 1].function_code == ModbusFunctionCode::READ_HOLDING_REGISTERS);
+    CHECK_EQ(rig.log[next + 1].address, VTRSimulator::REG_SETPOINT);
+  }
+  CHECK_EQ(rig.units[1]->sim.get_register(ModbusRegisterType::HOLDING, VTRSimulator::REG_SETPOINT), 230);
+  CHECK_EQ(rig.units[0]->sim.writes(), 0u);
+}
+
+// After setup the update_interval polls of the two units run half an interval apart
+TEST_CASE(shared_bus_polls_are_phase_shifted) {
+  SharedBusRig rig;
+  rig.setup();
+  rig.app.run_for(10000);
+  const uint64_t since_us = time_us();
+  rig.app.run_for(4 * 30000);
+
+  // One setpoint read per unit and cycle
+  std::vector<uint64_t> starts[2];
+  for (const auto &event : rig.log) {
+    if (event.start_us >= since_us && event.address == VTRSimulator::REG_SETPOINT)
+      starts[event.unit].push_back(event.start_us);
+  }
+  CHECK(starts[0].size() >= 3);
+  CHECK(starts[1].size() >= 3);
+  // Every poll of A is followed by one of B half an interval later
+  for (uint64_t a : starts[0]) {
+    for (uint64_t b : starts[1]) {
+      if (b > a) {
+        CHECK(b - a > 14000000 && b - a < 16000000);
+        break;
+      }
+    }
+  }
+  // With no contention the two bursts never interleave
+  const std::string turns = rig.turns(since_us);
+  CHECK(turns.find("AB") != std::string::npos);
+  CHECK(turns.find("ABA") == std::string::npos);
+  CHECK(turns.find("BAB") == std::string::npos);
+}
+
+// The coordinator publishes the share of the window some unit held the bus. A unit holds it
+// from the grant until the answer, so that is at least the wire time of every request and
+// at most that plus the controller's command_throttle per command.
+TEST_CASE(shared_bus_utilization) {
+  SharedBusRig rig;
+  rig.setup();
+  rig.app.run_for(61000);
+  rig.units[0]->sim.reset_counters();
+  rig.units[1]->sim.reset_counters();
+  rig.app.run_for(60000);
+
+  const uint64_t wire_us = rig.units[0]->sim.busy_us() + rig.units[1]->sim.busy_us();
+  const uint32_t commands = rig.units[0]->sim.requests() + rig.units[1]->sim.requests();
+  const float wire_share = 100.0f * wire_us / 60e6f;
+  CHECK(rig.utilization.has_state());
+  CHECK(rig.utilization.state >= wire_share);
+  CHECK(rig.utilization.state <= wire_share + 100.0f * commands * 200 / 60000);
+}
@@ -0,0 +1,74 @@
+#include <cmath>
+
+#include "check.h"
+#include "vtr_rig.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+static bool near(float actual, float expected) { return std::fabs(actual - expected) < 0.01f; }
+
+// Unchanged values are never written again; changing ones at most once per snapshot_interval
+TEST_CASE(snapshot_written_on_change_at_most_once_per_interval) {
+  VTRRig rig;
+  rig.climate.set_snapshot_interval(60000);
+  rig.setup();
+  // The first cycle changed every value, but the interval since boot has not passed yet
+  rig.app.run_for(5000);
+  CHECK_EQ(preference_saves(), 0u);
+  rig.app.run_for(60000);
+  CHECK_EQ(preference_saves(), 1u);
+
+  // Nothing changes on the unit: nothing to write
+  rig.app.run_for(5 * 60000);
+  CHECK_EQ(preference_saves(), 1u);
+
+  // The outdoor temperature changes every cycle: one write per interval
+  for (uint16_t i = 1; i <= 10; i++) {
+    rig.sim.set_register(ModbusRegisterType::HOLDING, VTRSimulator::REG_OUTDOOR_TEMP, 52 + i);
+    rig.app.run_for(30000);
+  }
+  CHECK(preference_saves() >= 1u + 4u);
+  CHECK(preference_saves() <= 1u + 5u);
+}
+
+// After a reboot the snapshot is published at once, marked stale and kept out of the cache
+// until the unit answers
+TEST_CASE(restored_values_are_stale_and_not_cached) {
+  // Both rigs clear the preferences when built, so build the rebooted one first
+  VTRRig rebooted;
+  rebooted.climate.set_snapshot_interval(60000);
+  VTRRig rig;
+  rig.climate.set_snapshot_interval(60000);
+  rig.sim.set_register(ModbusRegisterType::HOLDING, VTRSimulator::REG_OUTDOOR_TEMP, 75);
+  rig.setup();
+  rig.app.run_for(70000);
+  CHECK_EQ(preference_saves(), 1u);
+
+  rebooted.setup();
+  CHECK(near(rebooted.outdoor_air_temp.state, 7.5f));
+  CHECK(near(rebooted.supply_air_temp.state, 18.3f));
+  CHECK(rebooted.stale.has_state() && rebooted.stale.state);
+  const auto &cache = rebooted.climate.get_cache();
+  CHECK(!cache[save_vtr::REGISTER_OUTDOOR_TEMP].valid);
+  CHECK(!cache[save_vtr::REGISTER_SUPPLY_TEMP].valid);
+
+  rebooted.app.run_for(5000);
+  CHECK(near(rebooted.outdoor_air_temp.state, 5.2f));
+  CHECK(!rebooted.stale.state);
+  CHECK(cache[save_vtr::REGISTER_OUTDOOR_TEMP].valid);
+}
+
+// With snapshot_interval 0 nothing is written or restored
+TEST_CASE(snapshot_disabled) {
+  VTRRig rebooted;
+  rebooted.climate.set_snapshot_interval(0);
+  VTRRig rig;
+  rig.climate.set_snapshot_interval(0);
+  rig.setup();
+  rig.app.run_for(70000);
+  CHECK_EQ(preference_saves(), 0u);
+
+  rebooted.setup();
+  CHECK(std::isnan(rebooted.outdoor_air_temp.state));
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "esphome/components/binary_sensor/binary_sensor.h"
+#include "esphome/components/modbus_controller/modbus_controller.h"
+#include "esphome/components/save_vtr/save_vtr.h"
+#include "esphome/components/sensor/sensor.h"
+#include "host_app.h"
+#include "vtr_simulator.h"
+
+namespace esphome {
+namespace host {
+
+// Exposes the write lane so tests can write registers control() never touches
+class TestClimate : public save_vtr::SaveVTRClimate {
+ public:
+  using SaveVTRClimate::queue_write_;
+};
+
+// A SaveVTRClimate with every sensor of the example configuration, wired up the way the
+// generated code does it, on a controller that talks to a VTRSimulator. Tests adjust the
+// configuration before setup().
+struct VTRRig {
+  explicit VTRRig(const LinkConfig &link = {}, uint16_t command_throttle = 200) : sim(link) {
+    clear_preferences();
+    this->controller.set_transport(&this->sim);
+    this->controller.set_command_throttle(command_throttle);
+    this->climate.set_name("SAVE Climate");
+    this->climate.set_modbus(&this->controller);
+    this->climate.set_update_interval(30000);
+
+    this->add_sensor_(this->saf_percent, "Supply Airflow %", save_vtr::REGISTER_SUPPLY_AIRFLOW);
+    this->climate.set_saf_percent_sensor(&this->saf_percent);
+    this->add_sensor_(this->saf_volume, "Supply Airflow Volume", save_vtr::REGISTER_SUPPLY_AIRFLOW);
+    this->climate.set_saf_volume_sensor(&this->saf_volume);
+    this->add_sensor_(this->eaf_percent, "Extract Airflow %", save_vtr::REGISTER_EXTRACT_AIRFLOW);
+    this->climate.set_eaf_percent_sensor(&this->eaf_percent);
+    this->add_sensor_(this->eaf_volume, "Extract Airflow Volume", save_vtr::REGISTER_EXTRACT_AIRFLOW);
+    this->climate.set_eaf_volume_sensor(&this->eaf_volume);
+    this->add_sensor_(this->heat_demand, "Heat Demand", save_vtr::REGISTER_HEAT_DEMAND);
+    this->climate.set_heat_demand_sensor(&this->heat_demand);
+    this->add_sensor_(this->outdoor_air_temp, "Outdoor Air Temp", save_vtr::REGISTER_OUTDOOR_TEMP);
+    this->climate.set_outdoor_air_temp_sensor(&this->outdoor_air_temp);
+    this->add_sensor_(this->supply_air_temp, "Supply Air Temp", save_vtr::REGISTER_SUPPLY_TEMP);
+    this->climate.set_supply_air_temp_sensor(&this->supply_air_temp);
+    this->add_sensor_(this->extract_air_temp, "Extract Air Temp", save_vtr::REGISTER_EXTRACT_TEMP);
+    this->climate.set_extract_air_temp_sensor(&this->extract_air_temp);
+    this->add_sensor_(this->rpm_saf, "Supply Fan RPM", save_vtr::REGISTER_RPM_SAF);
+    this->climate.set_rpm_saf_sensor(&this->rpm_saf);
+    this->add_sensor_(this->rpm_eaf, "Extract Fan RPM", save_vtr::REGISTER_RPM_EAF);
+    this->climate.set_rpm_eaf_sensor(&this->rpm_eaf);
+    this->stale.set_name("SAVE Values Stale");
+    this->climate.set_stale_sensor(&this->stale);
+
+    this->app.register_component(&this->controller);
+    this->app.register_component(&this->climate);
+  }
+
+  void setup() { this->app.setup(); }
+
+  VTRSimulator sim;
+  modbus_controller::ModbusController controller;
+  TestClimate climate;
+  sensor::Sensor saf_percent;
+  sensor::Sensor saf_volume;
+  sensor::Sensor eaf_percent;
+  sensor::Sensor eaf_volume;
+  sensor::Sensor heat_demand;
+  sensor::Sensor outdoor_air_temp;
+  sensor::Sensor supply_air_temp;
+  sensor::Sensor extract_air_temp;
+  sensor::Sensor rpm_saf;
+  sensor::Sensor rpm_eaf;
+  binary_sensor::BinarySensor stale;
+  HostApp app;
+
+ protected:
+  void add_sensor_(sensor::Sensor &sensor, const char *name, save_vtr::RegisterId id) {
+    sensor.set_name(name);
+    this->climate.add_polled_register(id);
+  }
+};
+
+}  // namespace host
+}  // namespace esphome
@@ -0,0 +1,142 @@
+#include "vtr_simulator.h"
+#include "esphome/core/hal.h"
+
+namespace esphome {
+namespace host {
+
+using modbus_controller::ModbusFunctionCode;
+using modbus_controller::TransportResult;
+
+// Modbus RTU frame sizes in bytes (address, function, payload, CRC)
+static constexpr uint32_t RTU_READ_REQUEST = 8;
+static constexpr uint32_t RTU_READ_RESPONSE = 5;  // + 2 per register
+static constexpr uint32_t RTU_WRITE_SINGLE = 8;   // request and echoed response
+static constexpr uint32_t RTU_WRITE_MULTIPLE_REQUEST = 9;  // + 2 per register
+static constexpr uint32_t RTU_WRITE_MULTIPLE_RESPONSE = 8;
+static constexpr uint32_t RTU_EXCEPTION_RESPONSE = 5;
+
+VTRSimulator::VTRSimulator(const LinkConfig &config) : config_(config), rng_(config.seed) {
+  // A unit at 21.0°C setpoint in MANUAL, on a mild day
+  this->set_register(ModbusRegisterType::HOLDING, REG_SETPOINT, 210);
+  this->set_register(ModbusRegisterType::HOLDING, REG_SETPOINT + 1, 215);  // room temperature
+  this->set_register(ModbusRegisterType::HOLDING, REG_FAN_MODE_REQ, 2);
+  this->set_register(ModbusRegisterType::HOLDING, REG_OUTDOOR_TEMP, 52);
+  this->set_register(ModbusRegisterType::HOLDING, REG_SUPPLY_TEMP, 183);
+  this->set_register(ModbusRegisterType::HOLDING, REG_EXTRACT_TEMP, 221);
+  this->set_register(ModbusRegisterType::READ, REG_FAN_MODE, 1);
+  this->set_register(ModbusRegisterType::READ, REG_HEAT_DEMAND, 35);
+  this->set_register(ModbusRegisterType::READ, REG_RPM_SAF, 1810);
+  this->set_register(ModbusRegisterType::READ, REG_RPM_EAF, 1740);
+  this->set_register(ModbusRegisterType::READ, REG_SUPPLY_AIRFLOW, 60);
+  this->set_register(ModbusRegisterType::READ, REG_EXTRACT_AIRFLOW, 58);
+  this->set_register(ModbusRegisterType::READ, 7007, 0);   // filter alarm
+  this->set_register(ModbusRegisterType::READ, 14003, 0);  // output alarm
+}
+
+void VTRSimulator::set_register(ModbusRegisterType register_type, uint16_t address, uint16_t value) {
+  this->registers_[key_(register_type, address)] = value;
+}
+
+uint16_t VTRSimulator::get_register(ModbusRegisterType register_type, uint16_t address) const {
+  auto it = this->registers_.find(key_(register_type, address));
+  return it != this->registers_.end() ? it->second : 0;
+}
+
+uint32_t VTRSimulator::reads_of(ModbusRegisterType register_type, uint16_t address) const {
+  auto it = this->read_counts_.find(key_(register_type, address));
+  return it != this->read_counts_.end() ? it->second : 0;
+}
+
+void VTRSimulator::reset_counters() {
+  for (auto &entry : this->read_counts_)
+    entry.second = 0;
+  this->requests_ = 0;
+  this->reads_ = 0;
+  this->writes_ = 0;
+  this->dropped_ = 0;
+  this->crc_errors_ = 0;
+  this->bytes_on_wire_ = 0;
+  this->busy_us_ = 0;
+  this->request_log_.clear();
+}
+
+uint32_t VTRSimulator::frame_time_us_(uint32_t bytes) const {
+  // 3.5 characters of silence = 35 bit times at 10 bits per character
+  const uint64_t bits = uint64_t(bytes) * this->config_.bits_per_byte + this->config_.bits_per_byte * 7 / 2;
+  return bits * 1000000 / this->config_.baud_rate;
+}
+
+bool VTRSimulator::chance_(float rate) {
+  return rate > 0.0f && std::uniform_real_distribution<float>(0.0f, 1.0f)(this->rng_) < rate;
+}
+
+TransportResult VTRSimulator::transact(const modbus_controller::ModbusCommandItem &command,
+                                       std::vector<uint8_t> &response, uint32_t &wire_time_us) {
+  const bool is_read = command.function_code == ModbusFunctionCode::READ_HOLDING_REGISTERS ||
+                       command.function_code == ModbusFunctionCode::READ_INPUT_REGISTERS;
+  uint32_t request_bytes;
+  uint32_t response_bytes;
+  if (is_read) {
+    request_bytes = RTU_READ_REQUEST;
+    response_bytes = RTU_READ_RESPONSE + 2 * command.register_count;
+  } else if (command.function_code == ModbusFunctionCode::WRITE_SINGLE_REGISTER) {
+    request_bytes = RTU_WRITE_SINGLE;
+    response_bytes = RTU_WRITE_SINGLE;
+  } else {
+    request_bytes = RTU_WRITE_MULTIPLE_REQUEST + 2 * command.register_count;
+    response_bytes = RTU_WRITE_MULTIPLE_RESPONSE;
+  }
+
+  this->requests_++;
+  this->bytes_on_wire_ += request_bytes;
+  wire_time_us = this->frame_time_us_(request_bytes);
+  TransportResult result = TransportResult::ANSWERED;
+  if (!this->online_ || this->chance_(this->config_.drop_rate)) {
+    this->dropped_++;
+    result = TransportResult::NO_ANSWER;
+  } else {
+    const auto register_type = is_read ? command.register_type : ModbusRegisterType::HOLDING;
+    bool known = true;
+    for (uint16_t i = 0; i < command.register_count; i++)
+      known &= this->registers_.count(key_(register_type, command.register_address + i)) != 0;
+    if (!known)
+      response_bytes = RTU_EXCEPTION_RESPONSE;
+    wire_time_us += this->config_.response_latency_us + this->frame_time_us_(response_bytes);
+    this->bytes_on_wire_ += response_bytes;
+    if (this->chance_(this->config_.crc_error_rate)) {
+      this->crc_errors_++;
+      result = TransportResult::NO_ANSWER;
+    } else if (!known) {
+      result = TransportResult::EXCEPTION;
+    } else if (is_read) {
+      this->reads_++;
+      response.clear();
+      for (uint16_t i = 0; i < command.register_count; i++) {
+        const uint16_t value = this->get_register(register_type, command.register_address + i);
+        this->read_counts_[key_(register_type, command.register_address + i)]++;
+        response.push_back(value >> 8);
+        response.push_back(value & 0xFF);
+      }
+    } else {
+      this->writes_++;
+      for (uint16_t i = 0; i < command.register_count; i++) {
+        const uint16_t address = command.register_address + i;
+        const uint16_t value = (command.payload[2 * i] << 8) | command.payload[2 * i + 1];
+        this->set_register(ModbusRegisterType::HOLDING, address, value);
+        // The unit reports the requested mode 0-based in its input register
+        if (address == REG_FAN_MODE_REQ && value >= 1)
+          this->set_register(ModbusRegisterType::READ, REG_FAN_MODE, value - 1);
+      }
+      response.clear();
+    }
+  }
+  this->busy_us_ += wire_time_us;
+  if (this->record_requests_) {
+    this->request_log_.push_back(WireRequest{millis(), command.function_code, command.register_address,
+                                             command.register_count, result == TransportResult::ANSWERED});
+  }
+  return result;
+}
+
+}  // namespace host
+}  // namespace esphome
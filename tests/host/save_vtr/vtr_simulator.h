@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "esphome/components/modbus_controller/modbus_controller.h"
+
+namespace esphome {
+namespace host {
+
+using modbus_controller::ModbusRegisterType;
+
+// Electrical and timing behaviour of the RS-485 link to the unit
+struct LinkConfig {
+  uint32_t baud_rate{9600};
+  uint8_t bits_per_byte{10};            // start, 8 data, stop; 11 with parity
+  uint32_t response_latency_us{20000};  // unit turnaround between request and answer
+  float drop_rate{0.0f};                // requests the unit does not answer at all
+  float crc_error_rate{0.0f};           // answers that arrive corrupted and are discarded
+  uint32_t seed{1};
+};
+
+// One request as seen on the wire
+struct WireRequest {
+  uint32_t time;  // millis() when it went out
+  modbus_controller::ModbusFunctionCode function_code;
+  uint16_t address;
+  uint16_t count;
+  bool answered;
+};
+
+// Register file of a Systemair SAVE VTR unit behind a Modbus RTU link. Answers function 3,
+// 4, 6 and 16 from its register map, charges the wire time of every frame at the configured
+// baud rate and loses or corrupts frames at the configured rates (seeded, so runs repeat).
+// Writing the fan mode request register updates the fan mode register like the unit does.
+class VTRSimulator : public modbus_controller::ModbusTransport {
+ public:
+  static constexpr uint16_t REG_FAN_MODE = 1160;
+  static constexpr uint16_t REG_FAN_MODE_REQ = 1161;
+  static constexpr uint16_t REG_SETPOINT = 2000;
+  static constexpr uint16_t REG_HEAT_DEMAND = 2148;
+  static constexpr uint16_t REG_OUTDOOR_TEMP = 12101;
+  static constexpr uint16_t REG_SUPPLY_TEMP = 12102;
+  static constexpr uint16_t REG_RPM_SAF = 12400;
+  static constexpr uint16_t REG_RPM_EAF = 12401;
+  static constexpr uint16_t REG_EXTRACT_TEMP = 12543;
+  static constexpr uint16_t REG_SUPPLY_AIRFLOW = 14000;
+  static constexpr uint16_t REG_EXTRACT_AIRFLOW = 14001;
+
+  explicit VTRSimulator(const LinkConfig &config = {});
+
+  LinkConfig &config() { return this->config_; }
+  // A powered-off unit answers nothing
+  void set_online(bool online) { this->online_ = online; }
+
+  void set_register(ModbusRegisterType register_type, uint16_t address, uint16_t value);
+  uint16_t get_register(ModbusRegisterType register_type, uint16_t address) const;
+
+  modbus_controller::TransportResult transact(const modbus_controller::ModbusCommandItem &command,
+                                              std::vector<uint8_t> &response, uint32_t &wire_time_us) override;
+
+  // Counters since construction or reset_counters()
+  void reset_counters();
+  uint32_t requests() const { return this->requests_; }
+  uint32_t reads() const { return this->reads_; }
+  uint32_t writes() const { return this->writes_; }
+  uint32_t dropped() const { return this->dropped_; }
+  uint32_t crc_errors() const { return this->crc_errors_; }
+  uint64_t bytes_on_wire() const { return this->bytes_on_wire_; }
+  uint64_t busy_us() const { return this->busy_us_; }
+  // Read requests that covered the register
+  uint32_t reads_of(ModbusRegisterType register_type, uint16_t address) const;
+  // Every request, in order, while recording is on
+  void set_record_requests(bool record) { this->record_requests_ = record; }
+  const std::vector<WireRequest> &request_log() const { return this->request_log_; }
+
+ protected:
+  using Key = std::pair<uint8_t, uint16_t>;
+
+  static Key key_(ModbusRegisterType register_type, uint16_t address) {
+    return {static_cast<uint8_t>(register_type), address};
+  }
+  // Time on the wire of a frame of `bytes`, plus the 3.5 character silence that ends it
+  uint32_t frame_time_us_(uint32_t bytes) const;
+  bool chance_(float rate);
+
+  LinkConfig config_;
+  std::mt19937 rng_;
+  bool online_{true};
+  std::map<Key, uint16_t> registers_;
+  std::map<Key, uint32_t> read_counts_;
+  uint32_t requests_{0};
+  uint32_t reads_{0};
+  uint32_t writes_{0};
+  uint32_t dropped_{0};
+  uint32_t crc_errors_{0};
+  uint64_t bytes_on_wire_{0};
+  uint64_t busy_us_{0};
+  bool record_requests_{false};
+  std::vector<WireRequest> request_log_;
+};
+
+}  // namespace host
+}  // namespace esphome
@@ -0,0 +1,10 @@
+#pragma once
+
+// Generated in a real build, where it pulls in every configured component; the host build
+// only needs the core
+#include "esphome/core/automation.h"
+#include "esphome/core/component.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#include "esphome/core/preferences.h"
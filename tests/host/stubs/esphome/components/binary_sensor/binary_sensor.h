@@ -0,0 +1,42 @@
+#pragma once
+
+#include <functional>
+
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+namespace binary_sensor {
+
+// Like the real entity, callbacks only run when the state changes
+class BinarySensor : public EntityBase {
+ public:
+  void publish_state(bool state) {
+    if (this->has_state_ && this->state == state)
+      return;
+    this->has_state_ = true;
+    this->state = state;
+    this->callback_.call(state);
+  }
+  void publish_initial_state(bool state) {
+    this->has_state_ = false;
+    this->publish_state(state);
+  }
+  void invalidate_state() { this->has_state_ = false; }
+  bool has_state() const { return this->has_state_; }
+  void add_on_state_callback(std::function<void(bool)> &&callback) { this->callback_.add(std::move(callback)); }
+
+  bool state{false};
+
+ protected:
+  CallbackManager<void(bool)> callback_;
+  bool has_state_{false};
+};
+
+}  // namespace binary_sensor
+}  // namespace esphome
+
+#define LOG_BINARY_SENSOR(prefix, type, obj) \
+  if ((obj) != nullptr) { \
+    ESP_LOGCONFIG(TAG, "%s%s '%s'", prefix, type, (obj)->get_name().c_str()); \
+  }
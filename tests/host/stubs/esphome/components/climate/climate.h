@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <string>
+
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+namespace climate {
+
+enum ClimateMode : uint8_t {
+  CLIMATE_MODE_OFF = 0,
+  CLIMATE_MODE_HEAT_COOL,
+  CLIMATE_MODE_COOL,
+  CLIMATE_MODE_HEAT,
+  CLIMATE_MODE_FAN_ONLY,
+  CLIMATE_MODE_DRY,
+  CLIMATE_MODE_AUTO,
+};
+
+enum ClimateFeature : uint32_t {
+  CLIMATE_SUPPORTS_CURRENT_TEMPERATURE = 1 << 0,
+};
+
+class StringRef {
+ public:
+  StringRef() = default;
+  explicit StringRef(const char *str) : str_(str) {}
+  const char *c_str() const { return this->str_ != nullptr ? this->str_ : ""; }
+  std::string str() const { return this->c_str(); }
+
+ protected:
+  const char *str_{nullptr};
+};
+
+// Only what a component sets; nothing on the host reads it back
+class ClimateTraits {
+ public:
+  void add_feature_flags(uint32_t flags) { this->feature_flags_ |= flags; }
+  void set_visual_temperature_step(float step) {}
+  void set_visual_min_temperature(float temperature) {}
+  void set_visual_max_temperature(float temperature) {}
+  void set_supported_modes(std::initializer_list<ClimateMode> modes) {}
+  void set_supported_custom_fan_modes(std::initializer_list<const char *> modes) {}
+
+ protected:
+  uint32_t feature_flags_{0};
+};
+
+class Climate;
+
+class ClimateCall {
+ public:
+  explicit ClimateCall(Climate *parent) : parent_(parent) {}
+
+  ClimateCall &set_mode(ClimateMode mode) {
+    this->mode_ = mode;
+    return *this;
+  }
+  ClimateCall &set_target_temperature(float target_temperature) {
+    this->target_temperature_ = target_temperature;
+    return *this;
+  }
+  // The string must outlive the call, as with the string literals the real API takes
+  ClimateCall &set_fan_mode(const char *custom_fan_mode) {
+    this->custom_fan_mode_ = custom_fan_mode;
+    return *this;
+  }
+  void perform();
+
+  const optional<ClimateMode> &get_mode() const { return this->mode_; }
+  const optional<float> &get_target_temperature() const { return this->target_temperature_; }
+  bool has_custom_fan_mode() const { return this->custom_fan_mode_ != nullptr; }
+  StringRef get_custom_fan_mode() const { return StringRef(this->custom_fan_mode_); }
+
+ protected:
+  Climate *parent_;
+  optional<ClimateMode> mode_;
+  optional<float> target_temperature_;
+  const char *custom_fan_mode_{nullptr};
+};
+
+struct ClimateDeviceRestoreState {
+  void apply(Climate *climate) {}
+};
+
+class Climate : public EntityBase {
+ public:
+  ClimateCall make_call() { return ClimateCall(this); }
+  void publish_state() { this->state_callback_.call(*this); }
+  void add_on_state_callback(std::function<void(Climate &)> &&callback) {
+    this->state_callback_.add(std::move(callback));
+  }
+  bool has_custom_fan_mode() const { return this->custom_fan_mode_ != nullptr; }
+  StringRef get_custom_fan_mode() const { return StringRef(this->custom_fan_mode_); }
+
+  ClimateMode mode{CLIMATE_MODE_OFF};
+  float current_temperature{NAN};
+  float target_temperature{NAN};
+
+ protected:
+  friend ClimateCall;
+
+  virtual void control(const ClimateCall &call) = 0;
+  virtual ClimateTraits traits() = 0;
+  // Nothing is restored on the host
+  optional<ClimateDeviceRestoreState> restore_state_() { return {}; }
+  bool set_custom_fan_mode_(const char *mode) {
+    if (this->custom_fan_mode_ != nullptr && std::strcmp(this->custom_fan_mode_, mode) == 0)
+      return false;
+    this->custom_fan_mode_ = mode;
+    return true;
+  }
+
+  CallbackManager<void(Climate &)> state_callback_;
+  const char *custom_fan_mode_{nullptr};
+};
+
+inline void ClimateCall::perform() { this->parent_->control(*this); }
+
+}  // namespace climate
+}  // namespace esphome
+
+#define LOG_CLIMATE(prefix, type, obj) \
+  if ((obj) != nullptr) { \
+    ESP_LOGCONFIG(TAG, "%s%s '%s'", prefix, type, (obj)->get_name().c_str()); \
+  }
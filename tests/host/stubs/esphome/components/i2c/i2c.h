@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace i2c {
+
+enum ErrorCode {
+  NO_ERROR = 0,
+  ERROR_OK = 0,
+  ERROR_INVALID_ARGUMENT = 1,
+  ERROR_NOT_ACKNOWLEDGED = 2,
+  ERROR_TIMEOUT = 3,
+  ERROR_NOT_INITIALIZED = 4,
+  ERROR_TOO_LARGE = 5,
+  ERROR_UNKNOWN = 6,
+  ERROR_CRC = 7,
+};
+
+// The real bus splits transfers into buffers (readv/writev); one buffer per call is all the
+// components here use. Implemented by a simulated bus in the tests.
+class I2CBus {
+ public:
+  virtual ~I2CBus() = default;
+  virtual ErrorCode read(uint8_t address, uint8_t *buffer, size_t len) = 0;
+  virtual ErrorCode write(uint8_t address, const uint8_t *buffer, size_t len, bool stop = true) = 0;
+};
+
+// Register access like the real I2CDevice: a register read writes the register address,
+// then reads from it
+class I2CDevice {
+ public:
+  I2CDevice() = default;
+  I2CDevice(I2CBus *bus, uint8_t address) : address_(address), bus_(bus) {}
+
+  void set_i2c_address(uint8_t address) { this->address_ = address; }
+  void set_i2c_bus(I2CBus *bus) { this->bus_ = bus; }
+
+  ErrorCode read(uint8_t *data, size_t len) { return this->bus_->read(this->address_, data, len); }
+  ErrorCode write(const uint8_t *data, size_t len, bool stop = true) {
+    return this->bus_->write(this->address_, data, len, stop);
+  }
+
+  ErrorCode read_register(uint8_t a_register, uint8_t *data, size_t len, bool stop = true) {
+    const ErrorCode err = this->write(&a_register, 1, stop);
+    if (err != ERROR_OK)
+      return err;
+    return this->read(data, len);
+  }
+  ErrorCode write_register(uint8_t a_register, const uint8_t *data, size_t len, bool stop = true) {
+    uint8_t buffer[1 + 32];
+    if (len > sizeof(buffer) - 1)
+      return ERROR_TOO_LARGE;
+    buffer[0] = a_register;
+    std::memcpy(buffer + 1, data, len);
+    return this->write(buffer, len + 1, stop);
+  }
+
+  bool read_bytes(uint8_t a_register, uint8_t *data, uint8_t len) {
+    return this->read_register(a_register, data, len) == ERROR_OK;
+  }
+  bool write_bytes(uint8_t a_register, const uint8_t *data, uint8_t len) {
+    return this->write_register(a_register, data, len) == ERROR_OK;
+  }
+  bool read_byte(uint8_t a_register, uint8_t *data) { return this->read_bytes(a_register, data, 1); }
+  bool write_byte(uint8_t a_register, uint8_t data) { return this->write_bytes(a_register, &data, 1); }
+
+ protected:
+  uint8_t address_{0x00};
+  I2CBus *bus_{nullptr};
+};
+
+}  // namespace i2c
+}  // namespace esphome
+
+#define LOG_I2C_DEVICE(this) ESP_LOGCONFIG(TAG, "  Address: 0x%02X", this->address_);
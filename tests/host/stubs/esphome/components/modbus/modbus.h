@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace modbus {
+
+// The host build has no UART: the controller stand-in talks to a ModbusTransport instead
+class Modbus : public Component {};
+
+class ModbusDevice {
+ public:
+  void set_parent(Modbus *parent) { this->parent_ = parent; }
+  void set_address(uint8_t address) { this->address_ = address; }
+
+ protected:
+  Modbus *parent_{nullptr};
+  uint8_t address_{1};
+};
+
+}  // namespace modbus
+}  // namespace esphome
@@ -0,0 +1,116 @@
+#include "modbus_controller.h"
+#include "esphome/core/log.h"
+#include "alloc_counter.h"
+
+namespace esphome {
+namespace modbus_controller {
+
+static const char *const TAG = "modbus_controller";
+
+ModbusCommandItem ModbusCommandItem::create_read_command(ModbusController *modbusdevice,
+                                                         ModbusRegisterType register_type, uint16_t start_address,
+                                                         uint16_t register_count, DataHandler &&handler) {
+  ModbusCommandItem cmd;
+  cmd.modbusdevice = modbusdevice;
+  cmd.register_type = register_type;
+  cmd.function_code = register_type == ModbusRegisterType::HOLDING ? ModbusFunctionCode::READ_HOLDING_REGISTERS
+                                                                    : ModbusFunctionCode::READ_INPUT_REGISTERS;
+  cmd.register_address = start_address;
+  cmd.register_count = register_count;
+  cmd.on_data_func = std::move(handler);
+  return cmd;
+}
+
+ModbusCommandItem ModbusCommandItem::create_write_single_command(ModbusController *modbusdevice,
+                                                                 uint16_t start_address, uint16_t value) {
+  ModbusCommandItem cmd;
+  cmd.modbusdevice = modbusdevice;
+  cmd.register_type = ModbusRegisterType::HOLDING;
+  cmd.function_code = ModbusFunctionCode::WRITE_SINGLE_REGISTER;
+  cmd.register_address = start_address;
+  cmd.register_count = 1;
+  cmd.payload = {static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value & 0xFF)};
+  cmd.on_data_func = [](ModbusRegisterType, uint16_t, const std::vector<uint8_t> &) {};
+  return cmd;
+}
+
+ModbusCommandItem ModbusCommandItem::create_write_multiple_command(ModbusController *modbusdevice,
+                                                                   uint16_t start_address, uint16_t register_count,
+                                                                   const std::vector<uint16_t> &values) {
+  ModbusCommandItem cmd;
+  cmd.modbusdevice = modbusdevice;
+  cmd.register_type = ModbusRegisterType::HOLDING;
+  cmd.function_code = ModbusFunctionCode::WRITE_MULTIPLE_REGISTERS;
+  cmd.register_address = start_address;
+  cmd.register_count = register_count;
+  for (uint16_t value : values) {
+    cmd.payload.push_back(value >> 8);
+    cmd.payload.push_back(value & 0xFF);
+  }
+  cmd.on_data_func = [](ModbusRegisterType, uint16_t, const std::vector<uint8_t> &) {};
+  return cmd;
+}
+
+// The copy into the queue is what the real controller allocates per command; it is
+// counted apart from the allocations of the component that queued it
+void ModbusController::queue_command(const ModbusCommandItem &command) {
+  host::ExternalAllocationScope external;
+  for (auto &item : this->command_queue_) {
+    if (item->is_equal(command)) {
+      ESP_LOGW(TAG, "Duplicate modbus command found: type=0x%x address=%u count=%u",
+               static_cast<uint8_t>(command.register_type), command.register_address, command.register_count);
+      item->payload = command.payload;
+      return;
+    }
+  }
+  this->command_queue_.push_back(std::make_unique<ModbusCommandItem>(command));
+}
+
+void ModbusController::loop() {
+  if (this->waiting_) {
+    if (micros() - this->sent_at_us_ < this->busy_us_)
+      return;
+    this->waiting_ = false;
+    if (this->result_ != TransportResult::NO_ANSWER) {
+      std::unique_ptr<ModbusCommandItem> command;
+      {
+        host::ExternalAllocationScope external;
+        command = std::move(this->command_queue_.front());
+        this->command_queue_.pop_front();
+      }
+      if (this->result_ == TransportResult::ANSWERED && command->on_data_func)
+        command->on_data_func(command->register_type, command->register_address, this->response_);
+      host::ExternalAllocationScope external;
+      command.reset();
+    }
+    // Unanswered commands stay at the front and go out again
+  }
+  this->send_next_command_();
+}
+
+void ModbusController::send_next_command_() {
+  if (this->command_queue_.empty() || millis() - this->last_command_timestamp_ < this->command_throttle_)
+    return;
+  host::ExternalAllocationScope external;
+  auto &command = *this->command_queue_.front();
+  if (command.send_count > this->max_cmd_retries_) {
+    ESP_LOGD(TAG, "Modbus command to device=%u register=0x%02X no response received - removed from send queue",
+             this->address_, command.register_address);
+    this->command_queue_.pop_front();
+    return;
+  }
+  command.send_count++;
+  uint32_t wire_time = 0;
+  this->result_ = TransportResult::NO_ANSWER;
+  if (this->transport_ != nullptr)
+    this->result_ = this->transport_->transact(command, this->response_, wire_time);
+  this->busy_us_ = wire_time;
+  if (this->result_ == TransportResult::NO_ANSWER && this->busy_us_ < this->send_wait_time_ * 1000UL)
+    this->busy_us_ = this->send_wait_time_ * 1000UL;
+  this->sent_at_us_ = micros();
+  this->last_command_timestamp_ = millis();
+  this->waiting_ = true;
+}
+
+}  // namespace modbus_controller
+}  // namespace esphome
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "esphome/core/component.h"
+#include "esphome/components/modbus/modbus.h"
+
+namespace esphome {
+namespace modbus_controller {
+
+enum class ModbusFunctionCode : uint8_t {
+  CUSTOM = 0x00,
+  READ_COILS = 0x01,
+  READ_DISCRETE_INPUTS = 0x02,
+  READ_HOLDING_REGISTERS = 0x03,
+  READ_INPUT_REGISTERS = 0x04,
+  WRITE_SINGLE_COIL = 0x05,
+  WRITE_SINGLE_REGISTER = 0x06,
+  WRITE_MULTIPLE_REGISTERS = 0x10,
+};
+
+enum class ModbusRegisterType : uint8_t {
+  CUSTOM = 0x0,
+  COIL = 0x01,
+  DISCRETE_INPUT = 0x02,
+  HOLDING = 0x03,
+  READ = 0x04,
+};
+
+class ModbusController;
+
+class ModbusCommandItem {
+ public:
+  using DataHandler =
+      std::function<void(ModbusRegisterType register_type, uint16_t start_address, const std::vector<uint8_t> &data)>;
+
+  ModbusController *modbusdevice{nullptr};
+  uint16_t register_address{0};
+  uint16_t register_count{0};
+  ModbusFunctionCode function_code{ModbusFunctionCode::CUSTOM};
+  ModbusRegisterType register_type{ModbusRegisterType::CUSTOM};
+  DataHandler on_data_func;
+  std::vector<uint8_t> payload;
+  uint8_t send_count{0};  // times put on the wire
+
+  static ModbusCommandItem create_read_command(ModbusController *modbusdevice, ModbusRegisterType register_type,
+                                               uint16_t start_address, uint16_t register_count,
+                                               DataHandler &&handler);
+  static ModbusCommandItem create_write_single_command(ModbusController *modbusdevice, uint16_t start_address,
+                                                       uint16_t value);
+  static ModbusCommandItem create_write_multiple_command(ModbusController *modbusdevice, uint16_t start_address,
+                                                         uint16_t register_count, const std::vector<uint16_t> &values);
+
+  bool is_equal(const ModbusCommandItem &other) const {
+    return this->register_address == other.register_address && this->register_count == other.register_count &&
+           this->register_type == other.register_type && this->function_code == other.function_code;
+  }
+};
+
+// What answers on the simulated RS-485 line
+enum class TransportResult : uint8_t {
+  ANSWERED = 0,
+  NO_ANSWER,  // nothing, or a frame with a bad CRC; the controller waits out send_wait_time
+  EXCEPTION,  // the device rejected the request; the command is dropped
+};
+
+class ModbusTransport {
+ public:
+  virtual ~ModbusTransport() = default;
+  // Put one request on the wire. `response` gets the register bytes of an answered read and
+  // `wire_time_us` how long request, device turnaround and answer kept the line busy.
+  virtual TransportResult transact(const ModbusCommandItem &command, std::vector<uint8_t> &response,
+                                   uint32_t &wire_time_us) = 0;
+};
+
+// Host stand-in for the ESPHome controller with the same queueing behaviour: queue_command()
+// copies the command into a heap-allocated queue entry, one command is on the wire at a time,
+// the next goes out command_throttle after the previous one was sent, and an unanswered
+// command is resent up to max_cmd_retries times before it is dropped.
+class ModbusController : public PollingComponent, public modbus::ModbusDevice {
+ public:
+  void queue_command(const ModbusCommandItem &command);
+  void loop() override;
+  void update() override {}
+  float get_setup_priority() const override { return setup_priority::BUS; }
+
+  void set_transport(ModbusTransport *transport) { this->transport_ = transport; }
+  void set_command_throttle(uint16_t command_throttle) { this->command_throttle_ = command_throttle; }
+  void set_max_cmd_retries(uint8_t max_cmd_retries) { this->max_cmd_retries_ = max_cmd_retries; }
+  // Modbus::set_send_wait_time on the device: how long to wait for an answer
+  void set_send_wait_time(uint16_t send_wait_time) { this->send_wait_time_ = send_wait_time; }
+  size_t get_queue_size() const { return this->command_queue_.size(); }
+
+ protected:
+  void send_next_command_();
+
+  ModbusTransport *transport_{nullptr};
+  std::list<std::unique_ptr<ModbusCommandItem>> command_queue_;
+  std::vector<uint8_t> response_;
+  uint16_t command_throttle_{0};
+  uint8_t max_cmd_retries_{4};
+  uint16_t send_wait_time_{250};
+  uint32_t last_command_timestamp_{0};
+  bool waiting_{false};
+  TransportResult result_{TransportResult::NO_ANSWER};
+  uint32_t sent_at_us_{0};
+  uint32_t busy_us_{0};
+};
+
+}  // namespace modbus_controller
+}  // namespace esphome
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cmath>
+#include <functional>
+#include <string>
+
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+namespace sensor {
+
+// No filters on the host: raw and published state are the same
+class Sensor : public EntityBase {
+ public:
+  void publish_state(float state) {
+    this->raw_state = state;
+    this->state = state;
+    this->has_state_ = true;
+    this->callback_.call(state);
+  }
+  float get_state() const { return this->state; }
+  float get_raw_state() const { return this->raw_state; }
+  bool has_state() const { return this->has_state_; }
+  void set_accuracy_decimals(int8_t accuracy_decimals) { this->accuracy_decimals_ = accuracy_decimals; }
+  int8_t get_accuracy_decimals() { return this->accuracy_decimals_; }
+  void add_on_state_callback(std::function<void(float)> &&callback) { this->callback_.add(std::move(callback)); }
+
+  float state{NAN};
+  float raw_state{NAN};
+
+ protected:
+  CallbackManager<void(float)> callback_;
+  int8_t accuracy_decimals_{0};
+  bool has_state_{false};
+};
+
+}  // namespace sensor
+}  // namespace esphome
+
+#define LOG_SENSOR(prefix, type, obj) \
+  if ((obj) != nullptr) { \
+    ESP_LOGCONFIG(TAG, "%s%s '%s'", prefix, type, (obj)->get_name().c_str()); \
+  }
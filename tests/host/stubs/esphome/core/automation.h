@@ -0,0 +1,47 @@
+#pragma once
+
+#include <functional>
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+
+template<typename T, typename... X> class TemplatableValue {
+ public:
+  TemplatableValue() = default;
+  TemplatableValue(T value) : value_(value) {}
+  T value(X... x) { return this->value_; }
+
+ protected:
+  T value_{};
+};
+
+#define TEMPLATABLE_VALUE(type, name) \
+ protected: \
+  TemplatableValue<type, Ts...> name##_{}; \
+\
+ public: \
+  template<typename V> void set_##name(V name) { this->name##_ = name; }
+
+template<typename... Ts> class Trigger {
+ public:
+  void trigger(Ts... x) {}
+};
+
+template<typename... Ts> class Action {
+ public:
+  virtual ~Action() = default;
+  virtual void play(Ts... x) = 0;
+};
+
+template<typename T> class Parented {
+ public:
+  Parented() {}
+  Parented(T *parent) : parent_(parent) {}
+  void set_parent(T *parent) { this->parent_ = parent; }
+
+ protected:
+  T *parent_{nullptr};
+};
+
+}  // namespace esphome
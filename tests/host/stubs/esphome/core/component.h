@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#include "esphome/core/preferences.h"
+
+namespace esphome {
+
+namespace setup_priority {
+extern const float BUS;
+extern const float IO;
+extern const float HARDWARE;
+extern const float DATA;
+extern const float PROCESSOR;
+extern const float AFTER_WIFI;
+extern const float LATE;
+}  // namespace setup_priority
+
+class Component {
+ public:
+  virtual ~Component() = default;
+  virtual void setup() {}
+  virtual void loop() {}
+  virtual void dump_config() {}
+  virtual float get_setup_priority() const { return setup_priority::DATA; }
+
+  void mark_failed() { this->failed_ = true; }
+  bool is_failed() const { return this->failed_; }
+  void status_set_warning(const char *message = nullptr) { this->warning_ = true; }
+  void status_clear_warning() { this->warning_ = false; }
+  bool status_has_warning() const { return this->warning_; }
+
+ protected:
+  bool failed_{false};
+  bool warning_{false};
+};
+
+// update() is called by the harness every update_interval; see HostApp
+class PollingComponent : public Component {
+ public:
+  PollingComponent() = default;
+  explicit PollingComponent(uint32_t update_interval) : update_interval_(update_interval) {}
+
+  virtual void update() = 0;
+  virtual void set_update_interval(uint32_t update_interval) { this->update_interval_ = update_interval; }
+  virtual uint32_t get_update_interval() const { return this->update_interval_; }
+
+ protected:
+  uint32_t update_interval_{60000};
+};
+
+class EntityBase {
+ public:
+  void set_name(const std::string &name) { this->name_ = name; }
+  const std::string &get_name() const { return this->name_; }
+  std::string get_object_id() const;
+  uint32_t get_object_id_hash() { return fnv1_hash(this->get_object_id()); }
+
+ protected:
+  std::string name_;
+};
+
+}  // namespace esphome
+
+#define LOG_UPDATE_INTERVAL(this) \
+  ESP_LOGCONFIG(TAG, "  Update Interval: %.1fs", static_cast<float>(this->get_update_interval()) / 1000.0f)
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+
+// Host build: the clock is simulated and only moves when the harness advances it (or a
+// component calls delay()); see harness/host_app.h
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+}  // namespace esphome
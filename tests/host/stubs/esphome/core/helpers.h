@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace esphome {
+
+uint32_t fnv1_hash(const std::string &str);
+std::string str_sprintf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+template<typename T> class optional {
+ public:
+  optional() = default;
+  optional(const T &value) : has_value_(true), value_(value) {}
+
+  bool has_value() const { return this->has_value_; }
+  const T &value() const { return this->value_; }
+  const T &operator*() const { return this->value_; }
+  T *operator->() { return &this->value_; }
+  const T *operator->() const { return &this->value_; }
+  explicit operator bool() const { return this->has_value_; }
+
+ protected:
+  bool has_value_{false};
+  T value_{};
+};
+
+template<typename... X> class CallbackManager;
+
+template<typename... Ts> class CallbackManager<void(Ts...)> {
+ public:
+  void add(std::function<void(Ts...)> &&callback) { this->callbacks_.push_back(std::move(callback)); }
+  void call(Ts... args) {
+    for (auto &callback : this->callbacks_)
+      callback(args...);
+  }
+
+ protected:
+  std::vector<std::function<void(Ts...)>> callbacks_;
+};
+
+}  // namespace esphome
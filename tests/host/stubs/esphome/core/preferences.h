@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+
+// Host build: preferences live in an in-memory map keyed by the preference type, so a test
+// can "reboot" a component and see what it saved; see harness/host_app.h
+bool host_preference_save(uint32_t key, const void *data, size_t len);
+bool host_preference_load(uint32_t key, void *data, size_t len);
+
+class ESPPreferenceObject {
+ public:
+  ESPPreferenceObject() = default;
+  explicit ESPPreferenceObject(uint32_t key) : key_(key), valid_(true) {}
+
+  template<typename T> bool save(const T *src) { return this->valid_ && host_preference_save(this->key_, src, sizeof(T)); }
+  template<typename T> bool load(T *dest) { return this->valid_ && host_preference_load(this->key_, dest, sizeof(T)); }
+
+ protected:
+  uint32_t key_{0};
+  bool valid_{false};
+};
+
+class ESPPreferences {
+ public:
+  template<typename T> ESPPreferenceObject make_preference(uint32_t type, bool in_flash = false) {
+    return ESPPreferenceObject(type);
+  }
+};
+
+extern ESPPreferences *global_preferences;
+
+}  // namespace esphome
@@ -0,0 +1,126 @@
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include "esphome/core/component.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#include "esphome/core/preferences.h"
+#include "alloc_counter.h"
+#include "host_app.h"
+
+namespace esphome {
+
+namespace setup_priority {
+const float BUS = 1000.0f;
+const float IO = 900.0f;
+const float HARDWARE = 800.0f;
+const float DATA = 600.0f;
+const float PROCESSOR = 400.0f;
+const float AFTER_WIFI = 200.0f;
+const float LATE = -100.0f;
+}  // namespace setup_priority
+
+// Simulated clock
+static uint64_t host_time_us = 0;
+
+uint32_t millis() { return static_cast<uint32_t>(host_time_us / 1000); }
+uint32_t micros() { return static_cast<uint32_t>(host_time_us); }
+void delay(uint32_t ms) { host_time_us += uint64_t(ms) * 1000; }
+void delayMicroseconds(uint32_t us) { host_time_us += us; }
+
+namespace host {
+uint64_t time_us() { return host_time_us; }
+void advance_time_us(uint64_t us) { host_time_us += us; }
+}  // namespace host
+
+uint32_t fnv1_hash(const std::string &str) {
+  uint32_t hash = 2166136261UL;
+  for (char c : str) {
+    hash *= 16777619UL;
+    hash ^= c;
+  }
+  return hash;
+}
+
+std::string str_sprintf(const char *fmt, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  return buf;
+}
+
+std::string EntityBase::get_object_id() const {
+  std::string object_id;
+  for (char c : this->name_)
+    object_id += c == ' ' ? '_' : static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  return object_id;
+}
+
+// Logging
+
+static int host_log_level() {
+  static int level = -1;
+  if (level < 0) {
+    const char *env = std::getenv("HOST_LOG_LEVEL");
+    level = env != nullptr ? std::atoi(env) : ESPHOME_LOG_LEVEL_WARN;
+  }
+  return level;
+}
+
+void esp_log_printf_(int level, const char *tag, int line, const char *format, ...) {
+  if (level > host_log_level())
+    return;
+  host::ExternalAllocationScope external;
+  static const char LEVEL_LETTERS[] = "-EWICDVV";
+  std::fprintf(stderr, "[%9.3f][%c][%s:%03d]: ", host::time_us() / 1e6, LEVEL_LETTERS[level], tag, line);
+  va_list args;
+  va_start(args, format);
+  std::vfprintf(stderr, format, args);
+  va_end(args);
+  std::fputc('\n', stderr);
+}
+
+// Preferences: an in-memory flash
+
+static std::map<uint32_t, std::vector<uint8_t>> &host_preferences() {
+  static std::map<uint32_t, std::vector<uint8_t>> preferences;
+  return preferences;
+}
+
+static uint32_t host_preference_saves = 0;
+
+bool host_preference_save(uint32_t key, const void *data, size_t len) {
+  host::ExternalAllocationScope external;
+  host_preference_saves++;
+  const auto *bytes = static_cast<const uint8_t *>(data);
+  host_preferences()[key].assign(bytes, bytes + len);
+  return true;
+}
+
+bool host_preference_load(uint32_t key, void *data, size_t len) {
+  auto it = host_preferences().find(key);
+  if (it == host_preferences().end() || it->second.size() != len)
+    return false;
+  std::memcpy(data, it->second.data(), len);
+  return true;
+}
+
+namespace host {
+void clear_preferences() {
+  host_preferences().clear();
+  host_preference_saves = 0;
+}
+uint32_t preference_saves() { return host_preference_saves; }
+}  // namespace host
+
+static ESPPreferences host_global_preferences;
+ESPPreferences *global_preferences = &host_global_preferences;
+
+}  // namespace esphome